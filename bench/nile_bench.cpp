@@ -0,0 +1,290 @@
+#include "items/bird.hpp"
+#include "items/columns.hpp"
+#include "items/corde.hpp"
+#include "items/terrain.hpp"
+#include "items/vegetation.hpp"
+#include "helpers/interpolation.hpp"
+#include "helpers/linear_arena.hpp"
+#include "helpers/mesh_cache.hpp"
+#include "helpers/noise.hpp"
+#include "helpers/poisson_disk.hpp"
+#include "helpers/random.hpp"
+#include "helpers/thread_pool.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Micro-benchmarks of the CPU core (nile_core library): generators and simulations, no window and no OpenGL context
+//   nile_bench [--output results.json] [--baseline baseline.json] [--threshold percent] [--repeat n] [--seed n]
+//  - each benchmark runs over a range of sizes, the time kept is the best of n measures (the least disturbed one);
+//    short benchmarks are run several times per measure
+//  - the results are written as JSON, on stdout or in the --output file
+//  - a previous output can be given as baseline: the exit code is 1 when a benchmark is slower than its
+//    baseline by more than the threshold (10% by default)
+// The mesh cache is disabled: the generators are run every time instead of being read from cache/meshes/
+
+using namespace vcl;
+
+
+namespace {
+
+typedef std::chrono::steady_clock benchmark_clock;
+
+struct benchmark
+{
+    char const* name;
+    std::vector<size_t> sizes;              // meaning of the size given by the comment of each benchmark
+    std::function<void(size_t)> run;
+};
+
+struct benchmark_result
+{
+    std::string name;
+    size_t size;
+    double ms;
+};
+
+// results of the runs are written here so that the optimizer cannot remove the work
+volatile float sink;
+
+// terrain of the rope simulation, built once outside of the measures
+mesh rope_terrain;
+
+std::vector<benchmark> nile_benchmarks()
+{
+    std::vector<benchmark> benchmarks;
+
+    // size: N x N vertices, creation of the grid and computation of every region
+    benchmarks.push_back({ "terrain", { 50, 100, 200 }, [](size_t N) {
+        mesh terrain = create_terrain(unsigned(N));
+        compute_terrain(terrain, get_noise_params());
+        sink = terrain.position[terrain.position.size() / 2].z;
+    } });
+
+    // size: N x N evaluations of the Perlin noise of the terrain
+    benchmarks.push_back({ "noise", { 64, 128, 256 }, [](size_t N) {
+        perlin_noise_parameters const parameters = get_noise_params();
+        float sum = 0.0f;
+        for (size_t ku = 0; ku < N; ku++)
+            for (size_t kv = 0; kv < N; kv++)
+                sum += noise_perlin({ ku / (N - 1.0f), kv / (N - 1.0f) }, parameters.octave, parameters.persistency, parameters.frequency_gain);
+        sink = sum;
+    } });
+
+    // size: N x N evaluations of the noise of the terrain with its gradient (the normals come from it)
+    benchmarks.push_back({ "noise_gradient", { 64, 128, 256 }, [](size_t N) {
+        perlin_noise_parameters const parameters = get_noise_params();
+        float sum = 0.0f;
+        for (size_t ku = 0; ku < N; ku++)
+            for (size_t kv = 0; kv < N; kv++) {
+                noise_sample const noise = noise_perlin_gradient({ ku / (N - 1.0f), kv / (N - 1.0f) }, parameters.octave, parameters.persistency, parameters.frequency_gain);
+                sum += noise.value + noise.gradient.x;
+            }
+        sink = sum;
+    } });
+
+    // size: side of the square domain of the Poisson-disk sampling, with the density of the forest
+    benchmarks.push_back({ "placement", { 8, 16, 32 }, [](size_t side) {
+        poisson_disk_parameters parameters;
+        parameters.domain_min = { 0.0f, 0.0f };
+        parameters.domain_max = { float(side), float(side) };
+        parameters.radius = 0.25f;
+        parameters.density = [](vec2 const& p) { return forest_density(p.x, p.y); };
+        parameters.name = "bench_placement";
+        sink = float(poisson_disk_sample(parameters, default_thread_pool()).size());
+    } });
+
+    // size: level of recursion of the fern
+    benchmarks.push_back({ "fern", { 1, 2 }, [](size_t detail_level) {
+        sink = float(create_fern(1.0f, 0.3f, 0.1f, 0.03f, int(detail_level)).position.size());
+    } });
+
+    // size: number of leaves of the palm tree
+    benchmarks.push_back({ "palm_tree", { 5, 10, 20 }, [](size_t leaves) {
+        sink = float(create_palm_tree_shape(1.0f, int(leaves)).foliage.position.size());
+    } });
+
+    // size: number of columns generated
+    benchmarks.push_back({ "column", { 1, 4, 16 }, [](size_t count) {
+        for (size_t k = 0; k < count; k++)
+            sink = float(create_column_cyl(1.0f).position.size());
+    } });
+
+    // size: number of follower birds, 100 steps of the flock
+    benchmarks.push_back({ "flock", { 16, 64, 256 }, [](size_t count) {
+        buffer<vec3> key_positions;
+        buffer<float> key_times;
+        initialize_leader_path(key_positions, key_times);
+        rng_stream rng = rng_create("bench_flock");
+        std::vector<vec3> followers(count), speeds(count);
+        for (vec3& p : followers)
+            p = key_positions[1] + vec3(rng_uniform(rng, -1.0f, 1.0f), rng_uniform(rng, -1.0f, 1.0f), rng_uniform(rng, -0.2f, 0.2f));
+        float const dt = 0.02f;
+        for (int step = 0; step < 100; step++) {
+            float const t = key_times[1] + step * dt;
+            vec3 const leader = interpolation(t, key_positions, key_times);
+            vec3 const leader_speed = interpolation_derivative(t, key_positions, key_times);
+            update_follower_birds(leader, leader_speed, followers.data(), speeds.data(), count, t, dt, 0.0001f, 0.0001f, 0.005f);
+        }
+        sink = followers[0].x;
+    } });
+
+    // size: number of steps of the rope
+    benchmarks.push_back({ "rope", { 100, 1000, 10000 }, [](size_t steps) {
+        vec3 pos_poteau = { 5.5f, -7.5f, 0.1f };
+        vec3 const pos_bateau = vec3(0.0f, 0.0f, 0.2f) + get_translation_to_bow(0.1f);
+        buffer<vec3> particules, vitesses;
+        buffer<float> L0_array, raideurs;
+        initialize_corde(pos_bateau, pos_poteau, particules, vitesses, L0_array, raideurs);
+        float const dt = 0.005f;
+        for (size_t step = 0; step < steps; step++) {
+            frame_arena().reset();
+            update_pos_rope(pos_bateau, particules, vitesses, L0_array, raideurs, rope_terrain, step * dt, dt, 38.0f);
+        }
+        sink = particules[1].z;
+    } });
+
+    // size: number of evaluations of the cardinal spline of the leader bird
+    benchmarks.push_back({ "spline", { 1000, 10000, 100000 }, [](size_t samples) {
+        buffer<vec3> key_positions;
+        buffer<float> key_times;
+        initialize_leader_path(key_positions, key_times);
+        float const t_min = key_times[1];
+        float const t_max = key_times[key_times.size() - 2];
+        float sum = 0.0f;
+        for (size_t k = 0; k < samples; k++)
+            sum += interpolation(t_min + (t_max - t_min) * k / samples, key_positions, key_times).x;
+        sink = sum;
+    } });
+
+    return benchmarks;
+}
+
+double elapsed_ms(benchmark_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(benchmark_clock::now() - start).count();
+}
+
+// one result per line: read back by read_baseline()
+void write_json(std::ostream& out, std::vector<benchmark_result> const& results, int repeat)
+{
+    out << "{\n";
+    out << "  \"seed\": " << rng_global_seed() << ",\n";
+    out << "  \"threads\": " << default_thread_pool().size() << ",\n";
+    out << "  \"repeat\": " << repeat << ",\n";
+    out << "  \"results\": [\n";
+    for (size_t k = 0; k < results.size(); k++) {
+        char line[256];
+        std::snprintf(line, sizeof(line), "    { \"name\": \"%s\", \"size\": %zu, \"ms\": %.6f }%s\n",
+                      results[k].name.c_str(), results[k].size, results[k].ms, k + 1 < results.size() ? "," : "");
+        out << line;
+    }
+    out << "  ]\n}\n";
+}
+
+bool read_baseline(std::string const& filename, std::vector<benchmark_result>& baseline)
+{
+    std::ifstream in(filename);
+    if (!in)
+        return false;
+    std::string line;
+    while (std::getline(in, line)) {
+        char name[64];
+        size_t size = 0;
+        double ms = 0.0;
+        if (std::sscanf(line.c_str(), " { \"name\": \"%63[^\"]\", \"size\": %zu, \"ms\": %lf", name, &size, &ms) == 3)
+            baseline.push_back({ name, size, ms });
+    }
+    return true;
+}
+
+// number of benchmarks slower than their baseline by more than threshold percent
+int compare_with_baseline(std::vector<benchmark_result> const& results, std::vector<benchmark_result> const& baseline, double threshold)
+{
+    int regressions = 0;
+    for (benchmark_result const& r : results) {
+        auto const it = std::find_if(baseline.begin(), baseline.end(), [&r](benchmark_result const& b) { return b.name == r.name && b.size == r.size; });
+        if (it == baseline.end() || it->ms <= 0.0)
+            continue;
+        double const change = 100.0 * (r.ms / it->ms - 1.0);
+        bool const regression = change > threshold;
+        regressions += regression ? 1 : 0;
+        std::fprintf(stderr, "  %-14s %7zu  %10.3f ms -> %10.3f ms  %+7.1f%%%s\n",
+                     r.name.c_str(), r.size, it->ms, r.ms, change, regression ? "  REGRESSION" : "");
+    }
+    return regressions;
+}
+
+}
+
+
+int main(int argc, char** argv)
+{
+    std::string output_filename;
+    std::string baseline_filename;
+    double threshold = 10.0;
+    int repeat = 5;
+    rng_set_global_seed(1);
+    for (int k = 1; k + 1 < argc; k++) {
+        std::string const arg = argv[k];
+        if (arg == "--output")
+            output_filename = argv[k + 1];
+        if (arg == "--baseline")
+            baseline_filename = argv[k + 1];
+        if (arg == "--threshold")
+            threshold = std::strtod(argv[k + 1], nullptr);
+        if (arg == "--repeat")
+            repeat = std::max(1, std::atoi(argv[k + 1]));
+        if (arg == "--seed")
+            rng_set_global_seed(std::strtoull(argv[k + 1], nullptr, 10));
+    }
+
+    set_mesh_cache_enabled(false);
+    rope_terrain = create_terrain();
+    compute_terrain(rope_terrain, get_noise_params());
+
+    std::vector<benchmark_result> results;
+    for (benchmark const& b : nile_benchmarks()) {
+        for (size_t const size : b.sizes) {
+            // warm-up (caches, pool threads, first allocations), then enough runs per measure to last 1 ms at least
+            auto const warm_up = benchmark_clock::now();
+            b.run(size);
+            int const runs = std::max(1, int(1.0 / std::max(elapsed_ms(warm_up), 1e-4)));
+            double best = 1e30;
+            for (int k = 0; k < repeat; k++) {
+                auto const start = benchmark_clock::now();
+                for (int r = 0; r < runs; r++)
+                    b.run(size);
+                best = std::min(best, elapsed_ms(start) / runs);
+            }
+            results.push_back({ b.name, size, best });
+            std::fprintf(stderr, "  %-14s %7zu  %10.3f ms\n", b.name, size, best);
+        }
+    }
+
+    if (output_filename.empty())
+        write_json(std::cout, results, repeat);
+    else {
+        std::ofstream out(output_filename);
+        write_json(out, results, repeat);
+    }
+
+    if (baseline_filename.empty())
+        return 0;
+    std::vector<benchmark_result> baseline;
+    if (!read_baseline(baseline_filename, baseline)) {
+        std::fprintf(stderr, "Cannot read the baseline %s\n", baseline_filename.c_str());
+        return 1;
+    }
+    std::fprintf(stderr, "Comparison with %s (threshold %.1f%%)\n", baseline_filename.c_str(), threshold);
+    int const regressions = compare_with_baseline(results, baseline, threshold);
+    if (regressions > 0)
+        std::fprintf(stderr, "%d regression(s)\n", regressions);
+    return regressions > 0 ? 1 : 0;
+}
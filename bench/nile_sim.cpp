@@ -0,0 +1,208 @@
+#include "items/simulation.hpp"
+#include "items/terrain.hpp"
+#include "helpers/linear_arena.hpp"
+#include "helpers/mesh_cache.hpp"
+#include "helpers/random.hpp"
+#include "helpers/simulation_trace.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+// Headless run of the simulation (nile_core library): birds, boats, fleet and rope, no window and no OpenGL context
+//   nile_sim [--ticks n] [--seed n] [--dt s] [--substeps n] [--record trace.bin]
+//   nile_sim --replay trace.bin [--tolerance x] [--threshold percent]
+//   nile_sim --diff a.bin b.bin [--tolerance x]
+//  - the simulation advances by a fixed time step per tick (--dt) instead of the wall clock of the application:
+//    with the same seed, two runs give the same states tick after tick
+//  - --record writes the state of every tick in a binary trace (see helpers/simulation_trace.hpp)
+//  - --replay runs again the simulation of a trace (its seed, ticks and time step) and compares the states;
+//    the exit code is 1 when a channel differs by more than the tolerance, or when the throughput is lower
+//    than the recorded one by more than the threshold (no throughput check when the threshold is negative)
+//  - --diff compares two recorded traces
+// The water surface is not part of the simulated state: it only depends on the time
+
+using namespace vcl;
+
+
+namespace {
+
+typedef std::chrono::steady_clock simulation_clock;
+
+int const nb_agents[fleet_kind_count] = { 600, 300, 100 };
+
+struct run_parameters
+{
+    uint64_t seed = 1;
+    size_t ticks = 1000;
+    float tick_dt = 1.0f / 60.0f;
+    int substeps = 50;
+};
+
+// state of one tick appended to the trace, in the order of its channels
+void record_state(simulation_trace& trace, nile_simulation const& sim, entity_store const& world)
+{
+    auto push_transform = [&](entity e) {
+        trace.states.push_back(world.position[e].x);
+        trace.states.push_back(world.position[e].y);
+        trace.states.push_back(world.position[e].z);
+        trace.states.push_back(world.angle[e]);
+    };
+
+    push_transform(sim.leader_bird);
+    for (int i = 0; i < sim.nb_follower_birds; i++)
+        push_transform(sim.first_follower_bird + i);
+
+    push_transform(sim.drifting_boat);
+    push_transform(sim.moored_boat);
+
+    for (size_t k = 0; k < sim.boats.position.size(); k++) {
+        trace.states.push_back(sim.boats.position[k].x);
+        trace.states.push_back(sim.boats.position[k].y);
+        trace.states.push_back(sim.boats.position[k].z);
+        trace.states.push_back(sim.boats.heading[k]);
+    }
+
+    for (vec3 const& p : sim.particules.data) {
+        trace.states.push_back(p.x);
+        trace.states.push_back(p.y);
+        trace.states.push_back(p.z);
+    }
+}
+
+simulation_trace run_simulation(run_parameters const& parameters)
+{
+    rng_set_global_seed(parameters.seed);
+
+    mesh terrain = create_terrain();
+    compute_terrain(terrain, get_noise_params());
+
+    nile_simulation sim;
+    entity_store world;
+    sim.substeps = parameters.substeps;
+    initialize_simulation(sim, nb_agents);
+    create_simulation_entities(sim, world, { 0, true }, { 0, false });
+
+    simulation_trace trace;
+    trace.seed = parameters.seed;
+    trace.tick_dt = parameters.tick_dt;
+    trace.substeps = parameters.substeps;
+    add_trace_channel(trace, "birds", 4 * size_t(1 + sim.nb_follower_birds));
+    add_trace_channel(trace, "boats", 4 * 2);
+    add_trace_channel(trace, "fleet", 4 * sim.boats.position.size());
+    add_trace_channel(trace, "rope", 3 * sim.particules.size());
+    trace.states.reserve(parameters.ticks * trace.floats_per_tick());
+
+    // same sub-step as the application: the time of one tick is cut in substeps
+    float const dt = 1.0f / float(parameters.substeps);
+    auto const start = simulation_clock::now();
+    for (size_t tick = 0; tick < parameters.ticks; tick++) {
+        frame_arena().reset();
+        float const t = sim.t_min + std::fmod(float(tick) * parameters.tick_dt, sim.t_max - sim.t_min);
+        step_simulation(sim, world, terrain, t, dt);
+        record_state(trace, sim, world);
+    }
+    double const seconds = std::chrono::duration<double>(simulation_clock::now() - start).count();
+    trace.ticks_per_second = float(double(parameters.ticks) / std::max(seconds, 1e-9));
+    return trace;
+}
+
+// prints the differences, returns true when the traces match within the tolerance
+bool report_difference(simulation_trace const& a, simulation_trace const& b, float tolerance)
+{
+    trace_difference const difference = diff_traces(a, b, tolerance);
+    if (!difference.same_layout) {
+        std::fprintf(stderr, "Different traces: %zu ticks / %zu ticks, %zu channels / %zu channels\n", a.ticks(), b.ticks(), a.channels.size(), b.channels.size());
+        return false;
+    }
+    for (size_t c = 0; c < a.channels.size(); c++)
+        std::fprintf(stderr, "  %-8s max error %g\n", a.channels[c].name, double(difference.max_error[c]));
+    if (difference.first_tick >= 0) {
+        std::fprintf(stderr, "Divergence at tick %ld (tolerance %g)\n", difference.first_tick, double(tolerance));
+        return false;
+    }
+    std::fprintf(stderr, "Same states over %zu ticks (tolerance %g)\n", a.ticks(), double(tolerance));
+    return true;
+}
+
+}
+
+
+int main(int argc, char** argv)
+{
+    run_parameters parameters;
+    std::string record_filename;
+    std::string replay_filename;
+    std::string diff_filenames[2];
+    float tolerance = 0.0f;
+    double threshold = 10.0;
+    for (int k = 1; k + 1 < argc; k++) {
+        std::string const arg = argv[k];
+        if (arg == "--ticks")
+            parameters.ticks = std::strtoull(argv[k + 1], nullptr, 10);
+        if (arg == "--seed")
+            parameters.seed = std::strtoull(argv[k + 1], nullptr, 10);
+        if (arg == "--dt")
+            parameters.tick_dt = std::strtof(argv[k + 1], nullptr);
+        if (arg == "--substeps")
+            parameters.substeps = std::max(1, std::atoi(argv[k + 1]));
+        if (arg == "--record")
+            record_filename = argv[k + 1];
+        if (arg == "--replay")
+            replay_filename = argv[k + 1];
+        if (arg == "--tolerance")
+            tolerance = std::strtof(argv[k + 1], nullptr);
+        if (arg == "--threshold")
+            threshold = std::strtod(argv[k + 1], nullptr);
+        if (arg == "--diff" && k + 2 < argc) {
+            diff_filenames[0] = argv[k + 1];
+            diff_filenames[1] = argv[k + 2];
+        }
+    }
+
+    if (!diff_filenames[0].empty()) {
+        simulation_trace a, b;
+        for (int k = 0; k < 2; k++) {
+            if (!load_trace(diff_filenames[k], k == 0 ? a : b)) {
+                std::fprintf(stderr, "Cannot read the trace %s\n", diff_filenames[k].c_str());
+                return 1;
+            }
+        }
+        return report_difference(a, b, tolerance) ? 0 : 1;
+    }
+
+    simulation_trace reference;
+    if (!replay_filename.empty()) {
+        if (!load_trace(replay_filename, reference)) {
+            std::fprintf(stderr, "Cannot read the trace %s\n", replay_filename.c_str());
+            return 1;
+        }
+        parameters.seed = reference.seed;
+        parameters.ticks = reference.ticks();
+        parameters.tick_dt = reference.tick_dt;
+        parameters.substeps = reference.substeps;
+    }
+
+    // the generators are run every time instead of being read from cache/meshes/
+    set_mesh_cache_enabled(false);
+    simulation_trace const trace = run_simulation(parameters);
+    std::fprintf(stderr, "%zu ticks (seed %llu, dt %g s, %d substeps): %.1f ticks/s\n", trace.ticks(), static_cast<unsigned long long>(trace.seed), double(trace.tick_dt), trace.substeps, double(trace.ticks_per_second));
+
+    if (!record_filename.empty() && !save_trace(record_filename, trace)) {
+        std::fprintf(stderr, "Cannot write the trace %s\n", record_filename.c_str());
+        return 1;
+    }
+
+    if (replay_filename.empty())
+        return 0;
+    bool ok = report_difference(reference, trace, tolerance);
+    if (threshold >= 0.0 && reference.ticks_per_second > 0.0f) {
+        double const change = 100.0 * (double(reference.ticks_per_second) / double(trace.ticks_per_second) - 1.0);
+        std::fprintf(stderr, "Throughput %.1f ticks/s, recorded %.1f ticks/s (%+.1f%% time per tick, threshold %.1f%%)\n", double(trace.ticks_per_second), double(reference.ticks_per_second), change, threshold);
+        if (change > threshold)
+            ok = false;
+    }
+    return ok ? 0 : 1;
+}
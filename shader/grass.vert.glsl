@@ -0,0 +1,62 @@
+#version 330 core
+
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec3 normal;
+layout (location = 2) in vec3 color;
+layout (location = 3) in vec2 uv;                // uv.y : 0 at the base of the blade, 1 at the tip
+layout (location = 4) in vec3 instance_position; // root of the blade on the terrain
+layout (location = 5) in float instance_angle;   // rotation of the blade around z
+
+out struct fragment_data
+{
+    vec3 position;
+    vec3 normal;
+    vec3 color;
+    vec2 uv;
+	vec3 eye;
+} fragment;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+uniform vec3 grass_eye;          // camera position
+uniform vec2 grass_fade;         // distances where the grass starts to thin out and where it vanishes
+uniform float grass_scale;       // factor applied to the density to respect the blade budget
+uniform float grass_tile_blades; // number of blades of the tile drawn by this call
+
+uniform float wind_time;
+uniform vec2 wind;
+
+
+void main()
+{
+	// the blades of a tile are in random order: the first ones are kept when the density decreases,
+	// the blades close to the limit shrink instead of popping
+	float density = grass_scale * (1.0 - smoothstep(grass_fade.x, grass_fade.y, distance(instance_position, grass_eye)));
+	float rank = (float(gl_InstanceID) + 0.5) / grass_tile_blades;
+	float fade = clamp((density - rank) * 10.0, 0.0, 1.0);
+
+	// height varying from blade to blade
+	float h = 0.7 + 0.6 * fract(sin(dot(instance_position.xy, vec2(12.9898, 78.233))) * 43758.5453);
+
+	float c = cos(instance_angle);
+	float s = sin(instance_angle);
+	mat3 R = mat3(c, s, 0.0, -s, c, 0.0, 0.0, 0.0, 1.0);
+
+	vec3 p = R * vec3(model * vec4(position * vec3(1.0, h, h) * fade, 1.0));
+
+	// the tip bends with the wind, the root stays on the ground
+	float w = uv.y * uv.y * h * fade;
+	float sway = sin(2.5 * wind_time + dot(instance_position.xy, vec2(3.1, 2.7)));
+	p += w * vec3(0.5 * wind * (0.8 + 0.4 * sway), -0.15 * length(wind) * w);
+	p += instance_position;
+
+	fragment.position = p;
+	fragment.normal   = R * vec3(model * vec4(normal, 0.0));
+	fragment.color = color;
+	fragment.uv = uv;
+	fragment.eye = vec3(inverse(view)*vec4(0,0,0,1.0));
+
+	gl_Position = projection * view * vec4(p, 1.0);
+}
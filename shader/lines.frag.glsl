@@ -0,0 +1,11 @@
+#version 330 core
+
+in vec3 line_color;
+
+layout(location=0) out vec4 FragColor;
+
+
+void main()
+{
+	FragColor = vec4(line_color, 1.0);
+}
@@ -0,0 +1,16 @@
+#version 330 core
+
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec3 color;
+
+out vec3 line_color;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+
+void main()
+{
+	line_color = color;
+	gl_Position = projection * view * vec4(position, 1.0);
+}
@@ -0,0 +1,39 @@
+#version 330 core
+
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec3 normal;
+layout (location = 2) in vec3 color;
+layout (location = 3) in vec2 uv;
+layout (location = 4) in vec3 instance_position; // translation of the instance
+layout (location = 5) in float instance_angle;   // rotation of the instance around z
+
+out struct fragment_data
+{
+    vec3 position;
+    vec3 normal;
+    vec3 color;
+    vec2 uv;
+	vec3 eye;
+} fragment;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+
+void main()
+{
+	float c = cos(instance_angle);
+	float s = sin(instance_angle);
+	mat3 R = mat3(c, s, 0.0, -s, c, 0.0, 0.0, 0.0, 1.0);
+
+	vec3 p = R * vec3(model * vec4(position,1.0)) + instance_position;
+
+	fragment.position = p;
+	fragment.normal   = R * vec3(model * vec4(normal  ,0.0));
+	fragment.color = color;
+	fragment.uv = uv;
+	fragment.eye = vec3(inverse(view)*vec4(0,0,0,1.0));
+
+	gl_Position = projection * view * vec4(p, 1.0);
+}
@@ -0,0 +1,51 @@
+#version 330 core
+
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec3 normal;
+layout (location = 2) in vec3 color;
+layout (location = 3) in vec2 uv;
+layout (location = 6) in float wind_weight; // 0 on the rigid parts, 1 at the leaf tips
+
+out struct fragment_data
+{
+    vec3 position;
+    vec3 normal;
+    vec3 color;
+    vec2 uv;
+	vec3 eye;
+} fragment;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+uniform float wind_time;
+uniform vec2 wind; // direction and strength of the wind
+
+
+void main()
+{
+	vec4 p = model * vec4(position, 1.0);
+	vec3 n = vec3(model * vec4(normal, 0.0));
+
+	// each instance gets its own phase from its translation, so that the plants do not move together
+	float phase = dot(model[3].xy, vec2(1.7, 2.3));
+	float strength = length(wind);
+
+	// slow gusts bending the leaves in the direction of the wind, faster sway and flutter around it
+	float gust = 0.7 + 0.3 * sin(0.6 * wind_time + 0.5 * phase);
+	float sway = sin(2.1 * wind_time + phase + 0.8 * p.x);
+	float flutter = sin(9.0 * wind_time + 13.0 * (p.x + p.y));
+
+	float w = wind_weight;
+	p.xyz += w * vec3(wind * (gust + 0.4 * sway), -0.5 * strength * w * gust);
+	p.xyz += 0.15 * strength * w * flutter * normalize(n);
+
+	fragment.position = p.xyz;
+	fragment.normal   = n;
+	fragment.color = color;
+	fragment.uv = uv;
+	fragment.eye = vec3(inverse(view)*vec4(0,0,0,1.0));
+
+	gl_Position = projection * view * p;
+}
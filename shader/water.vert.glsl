@@ -0,0 +1,92 @@
+#version 330 core
+
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec3 normal;
+layout (location = 2) in vec3 color;
+layout (location = 3) in vec2 uv;
+layout (location = 6) in float water_weight; // 1 in the water, 0 on the bank
+
+out struct fragment_data
+{
+    vec3 position;
+    vec3 normal;
+    vec3 color;
+    vec2 uv;
+	vec3 eye;
+} fragment;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+uniform float water_time;
+uniform float water_period; // the frequency gain of the waves oscillates over this period
+uniform float water_height; // amplitude of the noise
+
+// size of the terrain domain (evaluate_terrain): (u,v) = (x,y)/domain + 0.5
+const vec2 domain = vec2(16.0, 30.0);
+
+
+vec2 gradient_at(vec2 cell)
+{
+	float a = 6.2831853 * fract(sin(dot(cell, vec2(127.1, 311.7))) * 43758.5453);
+	return vec2(cos(a), sin(a));
+}
+
+// gradient noise in [-1,1] and its derivatives: (value, d/dx, d/dy)
+vec3 noise_gradient(vec2 p)
+{
+	vec2 i = floor(p);
+	vec2 f = fract(p);
+	vec2 s = f * f * f * (f * (f * 6.0 - 15.0) + 10.0);
+	vec2 ds = 30.0 * f * f * (f * (f - 2.0) + 1.0);
+
+	vec2 ga = gradient_at(i);
+	vec2 gb = gradient_at(i + vec2(1.0, 0.0));
+	vec2 gc = gradient_at(i + vec2(0.0, 1.0));
+	vec2 gd = gradient_at(i + vec2(1.0, 1.0));
+	float va = dot(ga, f);
+	float vb = dot(gb, f - vec2(1.0, 0.0));
+	float vc = dot(gc, f - vec2(0.0, 1.0));
+	float vd = dot(gd, f - vec2(1.0, 1.0));
+
+	float k = va - vb - vc + vd;
+	float value = va + s.x * (vb - va) + s.y * (vc - va) + s.x * s.y * k;
+	vec2 d = ga + s.x * (gb - ga) + s.y * (gc - ga) + s.x * s.y * (ga - gb - gc + gd)
+		+ ds * (s.yx * k + vec2(vb, vc) - va);
+	return 1.41421356 * vec3(value, d);
+}
+
+// same sum of octaves as vcl::noise_perlin (6 octaves, persistency 0.6), with its derivatives
+vec3 waves(vec2 p, float frequency_gain)
+{
+	vec3 sum = vec3(0.0);
+	float a = 1.0;
+	float f = 1.0;
+	for (int k = 0; k < 6; k++) {
+		vec3 n = noise_gradient(f * p);
+		sum += a * vec3(0.5 + 0.5 * n.x, 0.5 * f * n.yz);
+		f *= frequency_gain;
+		a *= 0.6;
+	}
+	return sum;
+}
+
+
+void main()
+{
+	float gain = 2.25 - 0.3 * sin(1.5707963 + 3.1415927 * water_time / water_period);
+	vec3 h = water_height * waves(position.xy / domain + 0.5, gain);
+
+	// height and normal of the waves in the water, unchanged vertices on the bank
+	vec3 p = vec3(position.xy, mix(position.z, h.x, water_weight));
+	vec3 n = mix(normal, normalize(vec3(-h.yz / domain, 1.0)), water_weight);
+
+	fragment.position = vec3(model * vec4(p, 1.0));
+	fragment.normal   = vec3(model * vec4(n, 0.0));
+	fragment.color = color;
+	fragment.uv = uv;
+	fragment.eye = vec3(inverse(view)*vec4(0,0,0,1.0));
+
+	gl_Position = projection * view * model * vec4(p, 1.0);
+}
@@ -0,0 +1,62 @@
+#include "allocation_counter.hpp"
+#include <cstdlib>
+#include <new>
+
+
+namespace {
+
+// plain thread_local integers: no constructor, usable from operator new at any time
+thread_local size_t thread_allocation_count = 0;
+thread_local size_t thread_allocation_bytes = 0;
+
+void* counted_allocation(size_t size)
+{
+    thread_allocation_count++;
+    thread_allocation_bytes += size;
+    void* p = std::malloc(size > 0 ? size : 1);
+    if (p == nullptr)
+        throw std::bad_alloc();
+    return p;
+}
+
+}
+
+
+allocation_statistics thread_allocations()
+{
+    allocation_statistics s;
+    s.allocations = thread_allocation_count;
+    s.bytes = thread_allocation_bytes;
+    return s;
+}
+
+allocation_statistics operator-(allocation_statistics const& after, allocation_statistics const& before)
+{
+    allocation_statistics s;
+    s.allocations = after.allocations - before.allocations;
+    s.bytes = after.bytes - before.bytes;
+    return s;
+}
+
+
+// replacement of the global allocation functions (every form without alignment, C++14)
+void* operator new(size_t size) { return counted_allocation(size); }
+void* operator new[](size_t size) { return counted_allocation(size); }
+
+void* operator new(size_t size, std::nothrow_t const&) noexcept
+{
+    try { return counted_allocation(size); }
+    catch (...) { return nullptr; }
+}
+void* operator new[](size_t size, std::nothrow_t const&) noexcept
+{
+    try { return counted_allocation(size); }
+    catch (...) { return nullptr; }
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::nothrow_t const&) noexcept { std::free(p); }
+void operator delete[](void* p, std::nothrow_t const&) noexcept { std::free(p); }
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstddef>
+
+// Count of the heap allocations, made through the global operator new (replaced in allocation_counter.cpp)
+// The counters are kept per thread: a frame loop reads them before and after a frame to check that it does not allocate
+struct allocation_statistics
+{
+    size_t allocations = 0;
+    size_t bytes = 0;
+};
+
+// allocations made by the calling thread since it started
+allocation_statistics thread_allocations();
+
+// allocations made by a thread between two readings of thread_allocations()
+allocation_statistics operator-(allocation_statistics const& after, allocation_statistics const& before);
@@ -0,0 +1,34 @@
+#include "entity_store.hpp"
+
+using namespace vcl;
+
+
+entity create_entities(entity_store& store, size_t n, uint32_t components)
+{
+    entity const first = entity(store.size());
+    size_t const N = store.size() + n;
+
+    // every component array grows together: the index of an entity is valid in all of them
+    store.mask.resize(N, components);
+    store.position.resize(N, vec3(0.0f, 0.0f, 0.0f));
+    store.angle.resize(N, 0.0f);
+    store.scale.resize(N, 1.0f);
+    store.mesh.resize(N);
+    store.velocity.resize(N, vec3(0.0f, 0.0f, 0.0f));
+    store.spline.resize(N);
+    store.anchor.resize(N);
+    return first;
+}
+
+void clear(entity_store& store)
+{
+    store = entity_store();
+}
+
+size_t count_entities(entity_store const& store, uint32_t components)
+{
+    size_t count = 0;
+    for (uint32_t m : store.mask)
+        count += (m & components) == components;
+    return count;
+}
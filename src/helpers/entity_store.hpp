@@ -0,0 +1,79 @@
+#pragma once
+
+#include "vcl/vcl.hpp"
+#include <cstdint>
+#include <vector>
+
+// Entity-component store of the scene
+//  - an entity is an index; each component is a contiguous array indexed by entity
+//  - mask[e] tells which components the entity has, systems walk the arrays and skip the other entities
+//  - entities created together get consecutive indices, so a system can also work on a plain range
+//    (e.g. the positions and velocities of a flock are two contiguous slices)
+// The scene is built once at startup: entities are never destroyed, only the whole store is cleared
+
+typedef uint32_t entity;
+
+enum component_flag : uint32_t
+{
+    component_transform = 1u << 0,
+    component_mesh = 1u << 1,
+    component_velocity = 1u << 2,
+    component_spline = 1u << 3,
+    component_rope_anchor = 1u << 4
+};
+
+// Drawable used for an entity: index in the table of mesh_drawables or of hierarchy_mesh_drawables of the scene
+struct mesh_ref
+{
+    int drawable = -1;
+    bool hierarchy = false;
+};
+
+// Entity moved along an interpolated key-frame path
+struct spline_follower
+{
+    vcl::buffer<vcl::vec3> const* key_positions = nullptr;
+    vcl::buffer<float> const* key_times = nullptr;
+};
+
+// End of a rope attached to another entity, at an offset from its position
+struct rope_anchor
+{
+    entity target = 0;
+    vcl::vec3 offset;
+};
+
+struct entity_store
+{
+    std::vector<uint32_t> mask;
+
+    // transform: translation, rotation around z and uniform scale
+    std::vector<vcl::vec3> position;
+    std::vector<float> angle;
+    std::vector<float> scale;
+
+    std::vector<mesh_ref> mesh;
+    std::vector<vcl::vec3> velocity;
+    std::vector<spline_follower> spline;
+    std::vector<rope_anchor> anchor;
+
+    size_t size() const { return mask.size(); }
+    bool has(entity e, uint32_t components) const { return (mask[e] & components) == components; }
+};
+
+// Create n consecutive entities with the given components (default values), return the first one
+entity create_entities(entity_store& store, size_t n, uint32_t components);
+void clear(entity_store& store);
+
+// Number of entities having all the given components
+size_t count_entities(entity_store const& store, uint32_t components);
+
+// Call f(e) for every entity having all the given components, in increasing order
+template <typename F>
+void for_each_entity(entity_store const& store, uint32_t components, F const& f)
+{
+    size_t const N = store.size();
+    for (size_t e = 0; e < N; e++)
+        if ((store.mask[e] & components) == components)
+            f(entity(e));
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+// Three copies of a value exchanged between one writer thread and one reader thread without locking
+//  - the writer fills write_buffer() then publish() makes it the latest value
+//  - the reader calls acquire() to take the latest published value, then reads read_buffer() as long as it needs:
+//    the writer never touches the copy being read, it alternates between the two others
+// The copies are reused: their allocations are kept from one exchange to the next
+template <typename T>
+struct triple_buffer
+{
+    T& write_buffer() { return slots[write_index]; }
+    T const& read_buffer() const { return slots[read_index]; }
+
+    void publish()
+    {
+        write_index = middle.exchange(write_index | fresh, std::memory_order_acq_rel) & index_mask;
+    }
+
+    // Return false (and keep the current copy) if nothing was published since the last call
+    bool acquire()
+    {
+        if ((middle.load(std::memory_order_acquire) & fresh) == 0)
+            return false;
+        read_index = middle.exchange(read_index, std::memory_order_acq_rel) & index_mask;
+        return true;
+    }
+
+private:
+    static int const index_mask = 3;
+    static int const fresh = 4;     // set in middle when it holds a value the reader has not taken yet
+
+    T slots[3];
+    int write_index = 0;            // owned by the writer
+    int read_index = 1;             // owned by the reader
+    std::atomic<int> middle{ 2 };   // copy in transit, with the fresh bit
+};
+
+// Simulation thread producing one snapshot of the render state per frame, consumed by the render thread
+//  - the simulation of frame N+1 runs while the render thread submits frame N
+//  - the simulation stays at most one frame ahead: it waits for the previous snapshot to be acquired before the next step
+template <typename SNAPSHOT>
+struct frame_pipeline
+{
+    frame_pipeline() = default;
+    frame_pipeline(frame_pipeline const&) = delete;
+    frame_pipeline& operator=(frame_pipeline const&) = delete;
+    ~frame_pipeline() { stop(); }
+
+    // step fills the snapshot of the next frame, it is called on the simulation thread only
+    void start(std::function<void(SNAPSHOT&)> step)
+    {
+        simulation = std::thread([this, step]() {
+            while (true) {
+                auto const step_start = std::chrono::steady_clock::now();
+                try {
+                    step(snapshots.write_buffer());
+                }
+                catch (std::exception const& e) {
+                    std::cerr << "Error in simulation step: " << e.what() << std::endl;
+                }
+                step_ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - step_start).count();
+                snapshots.publish();
+
+                std::unique_lock<std::mutex> lock(mutex);
+                published++;
+                changed.notify_all();
+                changed.wait(lock, [this]() { return stopping || consumed == published; });
+                if (stopping)
+                    return;
+            }
+        });
+    }
+
+    void stop()
+    {
+        if (!simulation.joinable())
+            return;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        changed.notify_all();
+        simulation.join();
+    }
+
+    // Latest snapshot, waiting for the step of this frame if it is not over yet
+    // The reference stays valid until the next call
+    SNAPSHOT const& acquire()
+    {
+        auto const wait_start = std::chrono::steady_clock::now();
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [this]() { return published > consumed; });
+            snapshots.acquire();
+            consumed = published;
+        }
+        changed.notify_all(); // the simulation can start the next step
+        wait_ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - wait_start).count();
+        return snapshots.read_buffer();
+    }
+
+    // statistics of the last frame
+    std::atomic<float> step_ms{ 0.0f };     // duration of the simulation step
+    float wait_ms = 0.0f;                   // time the render thread waited for it
+
+private:
+    triple_buffer<SNAPSHOT> snapshots;
+    std::thread simulation;
+    std::mutex mutex;
+    std::condition_variable changed;
+    size_t published = 0;
+    size_t consumed = 0;
+    bool stopping = false;
+};
@@ -0,0 +1,13 @@
+#include "hash.hpp"
+
+
+std::string hash_to_string(uint64_t h)
+{
+    char const digits[] = "0123456789abcdef";
+    std::string s(16, '0');
+    for (int k = 15; k >= 0; --k) {
+        s[k] = digits[h & 0xf];
+        h >>= 4;
+    }
+    return s;
+}
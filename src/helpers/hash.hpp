@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// 64 bits FNV-1a hash, used as key by the on-disk caches (meshes, scenes, shaders) and to seed the random streams
+// Hashes can be chained by passing the previous result as h
+uint64_t const hash_fnv1a_offset = 0xcbf29ce484222325u;
+
+inline uint64_t hash_fnv1a(void const* data, size_t size, uint64_t h = hash_fnv1a_offset)
+{
+    unsigned char const* bytes = static_cast<unsigned char const*>(data);
+    for (size_t k = 0; k < size; ++k)
+        h = (h ^ uint64_t(bytes[k])) * 0x100000001b3u;
+    return h;
+}
+
+inline uint64_t hash_fnv1a(std::string const& s, uint64_t h = hash_fnv1a_offset)
+{
+    return hash_fnv1a(s.data(), s.size(), h);
+}
+
+// Hexadecimal representation used in file names
+std::string hash_to_string(uint64_t h);
@@ -0,0 +1,25 @@
+#include "instancing.hpp"
+
+using namespace vcl;
+
+
+void initialize_instancing(mesh_drawable& drawable)
+{
+    // The attributes advance once per instance (divisor 1) instead of once per vertex
+    glBindVertexArray(drawable.vao);
+    glEnableVertexAttribArray(4);
+    glVertexAttribDivisor(4, 1);
+    glEnableVertexAttribArray(5);
+    glVertexAttribDivisor(5, 1);
+    glBindVertexArray(0);
+}
+
+void stream_instancing(mesh_drawable& drawable, stream_buffer& stream, vec3 const* position, float const* angle, size_t count)
+{
+    if (count == 0)
+        return;
+    // both attributes in the same storage: an orphaning second write would lose the first one
+    stream_reserve(stream, count * (sizeof(vec3) + sizeof(float)), 2);
+    stream_vertex_attribute(stream, drawable.vao, 4, position, count);
+    stream_vertex_attribute(stream, drawable.vao, 5, angle, count);
+}
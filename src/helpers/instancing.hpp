@@ -0,0 +1,44 @@
+#pragma once
+
+#include "vcl/vcl.hpp"
+#include "stream_buffer.hpp"
+
+// Per-instance attributes (translation and rotation angle around z) of an instanced mesh_drawable
+// The attributes are read by shader/mesh_instanced.vert.glsl at locations 4 and 5
+
+// Enable the instance attributes in the vao of the drawable (their storage is given by stream_instancing)
+void initialize_instancing(vcl::mesh_drawable& drawable);
+
+// Send the per-instance data of the frame: written to the stream buffer, the attributes of the drawable point to it
+void stream_instancing(vcl::mesh_drawable& drawable, stream_buffer& stream, vcl::vec3 const* position, float const* angle, size_t count);
+
+template <typename SCENE>
+void draw_instanced(vcl::mesh_drawable const& drawable, size_t count, SCENE const& current_scene)
+{
+    if (count == 0) return;
+
+    // Setup shader
+    assert_vcl(drawable.shader!=0, "Try to draw mesh_drawable without shader");
+    assert_vcl(drawable.texture!=0, "Try to draw mesh_drawable without texture");
+    glUseProgram(drawable.shader); opengl_check;
+
+    // Send uniforms for this shader
+    opengl_uniform(drawable.shader, current_scene);
+    opengl_uniform(drawable.shader, drawable.shading, false);
+    opengl_uniform(drawable.shader, "model", drawable.transform.matrix());
+
+    // Set texture
+    glActiveTexture(GL_TEXTURE0); opengl_check;
+    glBindTexture(GL_TEXTURE_2D, drawable.texture); opengl_check;
+    vcl::opengl_uniform(drawable.shader, "image_texture", 0);  opengl_check;
+
+    // Call draw function: a single call for all the instances
+    assert_vcl(drawable.number_triangles>0, "Try to draw mesh_drawable with 0 triangles"); opengl_check;
+    glBindVertexArray(drawable.vao);   opengl_check;
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, drawable.vbo.at("index")); opengl_check;
+    glDrawElementsInstanced(GL_TRIANGLES, GLsizei(drawable.number_triangles*3), GL_UNSIGNED_INT, nullptr, GLsizei(count)); opengl_check;
+
+    // Clean buffers
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
@@ -29,6 +29,26 @@ vec3 const interpolation(float t, buffer<vec3> const& key_positions, buffer<floa
     return p;
 }
 
+// find velocity at time t
+vec3 const interpolation_derivative(float t, buffer<vec3> const& key_positions, buffer<float> const& key_times)
+{
+    int const idx = find_index_of_interval(t, key_times);
+
+    float const t0 = key_times[idx - 1];
+    float const t1 = key_times[idx  ];
+    float const t2 = key_times[idx+1];
+    float const t3 = key_times[idx + 2];
+
+    vec3 const& p0 = key_positions[idx - 1];
+    vec3 const& p1 = key_positions[idx  ];
+    vec3 const& p2 = key_positions[idx+1];
+    vec3 const& p3 = key_positions[idx + 2];
+
+    float const K = 0.5f;
+
+    return cardinal_spline_derivative(t, t0, t1, t2, t3, p0, p1, p2, p3, K);
+}
+
 
 vec3 linear_interpolation(float t, float t1, float t2, const vec3& p1, const vec3& p2)
 {
@@ -50,6 +70,17 @@ vec3 cardinal_spline_interpolation(float t, float t0, float t1, float t2, float
     return p;
 }
 
+vec3 cardinal_spline_derivative(float t, float t0, float t1, float t2, float t3, vec3 const& p0, vec3 const& p1, vec3 const& p2, vec3 const& p3, float K)
+{
+    // derivative of the Hermite basis with respect to s, then ds/dt = 1/(t2-t1)
+    float s = (t - t1) / (t2 - t1);
+    float s2 = s * s;
+    vec3 d2 = 2 * K * (p2 - p0) / (t2 - t0);
+    vec3 d3 = 2 * K * (p3 - p1) / (t3 - t1);
+    vec3 dp = (6 * s2 - 6 * s) * p1 + (3 * s2 - 4 * s + 1) * d2 + (-6 * s2 + 6 * s) * p2 + (3 * s2 - 2 * s) * d3;
+    return dp / (t2 - t1);
+}
+
 size_t find_index_of_interval(float t, buffer<float> const& intervals)
 {
     size_t const N = intervals.size();
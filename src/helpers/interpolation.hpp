@@ -6,6 +6,9 @@
 // Compute the interpolated position p(t) given a time t and the set of key_positions and key_frame
 vcl::vec3 const interpolation(float t, vcl::buffer<vcl::vec3> const& key_positions, vcl::buffer<float> const& key_times);
 
+// Compute the interpolated velocity p'(t) given a time t and the set of key_positions and key_frame
+vcl::vec3 const interpolation_derivative(float t, vcl::buffer<vcl::vec3> const& key_positions, vcl::buffer<float> const& key_times);
+
 /** Compute the linear interpolation p(t) between p1 at time t1 and p2 at time t2*/
 vcl::vec3 linear_interpolation(float t, float t1, float t2, const vcl::vec3& p1, const vcl::vec3& p2);
 
@@ -13,6 +16,10 @@ vcl::vec3 linear_interpolation(float t, float t1, float t2, const vcl::vec3& p1,
 *  - Assume t \in [t1,t2] */
 vcl::vec3 cardinal_spline_interpolation(float t, float t0, float t1, float t2, float t3, vcl::vec3 const& p0, vcl::vec3 const& p1, vcl::vec3 const& p2, vcl::vec3 const& p3, float K);
 
+/** Compute the time derivative p'(t) of the cardinal spline defined as in cardinal_spline_interpolation
+*  - Assume t \in [t1,t2] */
+vcl::vec3 cardinal_spline_derivative(float t, float t0, float t1, float t2, float t3, vcl::vec3 const& p0, vcl::vec3 const& p1, vcl::vec3 const& p2, vcl::vec3 const& p3, float K);
+
 /** Find the index k such that intervals[k] < t < intervals[k+1]
 * - Assume intervals is a sorted array of N time values
 * - Assume t \in [ intervals[0], intervals[N-1] [       */
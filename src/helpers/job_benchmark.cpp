@@ -0,0 +1,119 @@
+#include "job_benchmark.hpp"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <vector>
+
+
+namespace {
+
+typedef std::chrono::steady_clock benchmark_clock;
+
+float elapsed_ns(benchmark_clock::time_point start)
+{
+    return std::chrono::duration<float, std::nano>(benchmark_clock::now() - start).count();
+}
+
+void print_line(std::ostream& out, char const* name, size_t jobs, float total_ns)
+{
+    out << "  " << std::left << std::setw(28) << name << std::right << std::setw(9) << jobs << " jobs"
+        << std::fixed << std::setprecision(2) << std::setw(10) << total_ns * 1e-6f << " ms"
+        << std::setprecision(0) << std::setw(9) << total_ns / float(jobs) << " ns/job"
+        << std::setprecision(2) << std::setw(9) << float(jobs) / total_ns * 1e3f << " M jobs/s" << std::defaultfloat << std::endl;
+}
+
+// small amount of work that the optimizer cannot remove
+float tiny_work(size_t i)
+{
+    return std::sqrt(float(i) + 1.0f);
+}
+
+}
+
+
+void run_job_benchmark(thread_pool& pool, std::ostream& out)
+{
+    size_t const N = 200000;
+    thread_pool_statistics const before = pool.statistics();
+    out << "Job system benchmark (" << pool.size() << " workers)" << std::endl;
+
+    // empty jobs from the main thread: shared queue
+    {
+        std::atomic<size_t> counter{ 0 };
+        auto const start = benchmark_clock::now();
+        for (size_t k = 0; k < N; k++)
+            pool.submit([&counter]() { counter++; }, "empty");
+        pool.wait_idle();
+        print_line(out, "submit (main thread)", N, elapsed_ns(start));
+    }
+
+    // empty jobs from a worker: its own deque, the other workers steal
+    {
+        std::atomic<size_t> counter{ 0 };
+        auto const start = benchmark_clock::now();
+        pool.submit([&]() {
+            for (size_t k = 0; k < N; k++)
+                pool.submit([&counter]() { counter++; }, "empty");
+        }, "spawner");
+        pool.wait_idle();
+        print_line(out, "submit (worker)", N, elapsed_ns(start));
+    }
+
+    // fan-out / join: one root, 64 children depending on it, one join depending on all of them
+    {
+        size_t const graphs = N / 66;
+        std::atomic<size_t> counter{ 0 };
+        auto const start = benchmark_clock::now();
+        std::vector<job_handle> children(64);
+        for (size_t g = 0; g < graphs; g++) {
+            job_handle const root = pool.schedule([&counter]() { counter++; }, {}, "root");
+            for (job_handle& child : children)
+                child = pool.schedule([&counter]() { counter++; }, { root }, "child");
+            pool.wait(pool.schedule([&counter]() { counter++; }, children, "join"));
+        }
+        print_line(out, "schedule (fan-out / join)", graphs * 66, elapsed_ns(start));
+    }
+
+    // chain: every job depends on the previous one, no parallelism at all, pure dependency overhead
+    {
+        size_t const length = N / 10;
+        std::atomic<size_t> counter{ 0 };
+        auto const start = benchmark_clock::now();
+        job_handle previous;
+        for (size_t k = 0; k < length; k++)
+            previous = pool.schedule([&counter]() { counter++; }, { previous }, "chain");
+        pool.wait(previous);
+        print_line(out, "schedule (chain)", length, elapsed_ns(start));
+    }
+
+    // parallel_for over tiny iterations, compared with the serial loop
+    {
+        size_t const count = 1000000;
+        std::vector<float> values(count);
+
+        auto start = benchmark_clock::now();
+        for (size_t i = 0; i < count; i++)
+            values[i] = tiny_work(i);
+        float const serial_ns = elapsed_ns(start);
+
+        start = benchmark_clock::now();
+        parallel_for(pool, count, [&values](size_t i) { values[i] = tiny_work(i); });
+        float const parallel_ns = elapsed_ns(start);
+
+        start = benchmark_clock::now();
+        parallel_for_range(pool, count, [&values](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++)
+                values[i] = tiny_work(i);
+        });
+        float const range_ns = elapsed_ns(start);
+
+        print_line(out, "serial loop", count, serial_ns);
+        print_line(out, "parallel_for", count, parallel_ns);
+        print_line(out, "parallel_for_range", count, range_ns);
+        out << "  speedup parallel_for_range / serial: " << std::setprecision(2) << serial_ns / range_ns << std::endl;
+    }
+
+    thread_pool_statistics const after = pool.statistics();
+    out << "  jobs executed " << after.executed - before.executed << ", stolen " << after.stolen - before.stolen << std::endl;
+}
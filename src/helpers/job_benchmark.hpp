@@ -0,0 +1,11 @@
+#pragma once
+
+#include "thread_pool.hpp"
+#include <ostream>
+
+// Micro-benchmark of the job system on fine-grained tasks (option --bench-jobs)
+//  - submit: throughput of empty jobs submitted from the main thread, then from inside a worker
+//  - schedule: fan-out / join graphs, cost of a dependency compared with a plain job
+//  - parallel_for: tiny iterations against the same loop run serially
+// Times are per job (ns) so that the scheduling overhead can be compared with the size of the real tasks
+void run_job_benchmark(thread_pool& pool, std::ostream& out);
@@ -0,0 +1,49 @@
+#include "line_batch.hpp"
+#include <cstddef>
+
+using namespace vcl;
+
+
+void initialize_line_batch(line_batch& batch, GLuint shader)
+{
+    batch.shader = shader;
+    glGenVertexArrays(1, &batch.vao);
+    glBindVertexArray(batch.vao);
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    glBindVertexArray(0);
+}
+
+void add_segment(line_batch& batch, vec3 const& a, vec3 const& b, vec3 const& color)
+{
+    batch.vertices.push_back({ a, color });
+    batch.vertices.push_back({ b, color });
+}
+
+void add_polyline(line_batch& batch, vec3 const* points, size_t count, vec3 const& color)
+{
+    for (size_t k = 1; k < count; k++)
+        add_segment(batch, points[k - 1], points[k], color);
+}
+
+void add_frame(line_batch& batch, vec3 const& origin, float size)
+{
+    add_segment(batch, origin, origin + vec3(size, 0, 0), { 1,0,0 });
+    add_segment(batch, origin, origin + vec3(0, size, 0), { 0,1,0 });
+    add_segment(batch, origin, origin + vec3(0, 0, size), { 0,0,1 });
+}
+
+void upload_line_batch(line_batch& batch, stream_buffer& stream)
+{
+    size_t const count = batch.vertices.size();
+    if (count == 0)
+        return;
+
+    size_t const offset = stream_write(stream, batch.vertices.data(), count * sizeof(line_vertex));
+    glBindVertexArray(batch.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, stream.vbo);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(line_vertex), reinterpret_cast<void const*>(offset + offsetof(line_vertex, position)));
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(line_vertex), reinterpret_cast<void const*>(offset + offsetof(line_vertex, color)));
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "vcl/vcl.hpp"
+#include "stream_buffer.hpp"
+#include <vector>
+
+// Lines of a frame (ropes, trajectories, debug frames) collected on the CPU and drawn with a single call
+//  - add_* only appends vertices to an array whose capacity is kept from one frame to the next
+//  - draw_line_batch() writes the whole array to the stream buffer, draws it as GL_LINES and empties the batch
+// Drawn by shader/lines.vert.glsl and shader/lines.frag.glsl (color per vertex, no lighting)
+
+struct line_vertex
+{
+    vcl::vec3 position;
+    vcl::vec3 color;
+};
+
+struct line_batch
+{
+    std::vector<line_vertex> vertices;  // two per segment
+    GLuint shader = 0;
+    GLuint vao = 0;                     // its attributes point to the last write in the stream buffer
+
+    // statistics of the last draw
+    size_t drawn_segments = 0;
+};
+
+void initialize_line_batch(line_batch& batch, GLuint shader);
+
+void add_segment(line_batch& batch, vcl::vec3 const& a, vcl::vec3 const& b, vcl::vec3 const& color);
+// count points joined by count-1 segments
+void add_polyline(line_batch& batch, vcl::vec3 const* points, size_t count, vcl::vec3 const& color);
+// axes x, y, z in red, green, blue
+void add_frame(line_batch& batch, vcl::vec3 const& origin, float size);
+
+// Send the vertices of the batch to the GPU
+void upload_line_batch(line_batch& batch, stream_buffer& stream);
+
+template <typename SCENE>
+void draw_line_batch(line_batch& batch, stream_buffer& stream, SCENE const& current_scene)
+{
+    upload_line_batch(batch, stream);
+    batch.drawn_segments = batch.vertices.size() / 2;
+    batch.vertices.clear();
+    if (batch.drawn_segments == 0 || batch.shader == 0) return;
+
+    glUseProgram(batch.shader); opengl_check;
+    opengl_uniform(batch.shader, current_scene);
+
+    glBindVertexArray(batch.vao); opengl_check;
+    glDrawArrays(GL_LINES, 0, GLsizei(2 * batch.drawn_segments)); opengl_check;
+    glBindVertexArray(0);
+}
@@ -0,0 +1,60 @@
+#include "linear_arena.hpp"
+#include <algorithm>
+#include <cstdint>
+
+
+linear_arena::linear_arena(size_t capacity)
+{
+    if (capacity > 0)
+        add_block(capacity);
+}
+
+void linear_arena::add_block(size_t size)
+{
+    blocks.push_back({ std::unique_ptr<unsigned char[]>(new unsigned char[size]), size });
+    offset = 0;
+    nb_block_allocations++;
+}
+
+void* linear_arena::allocate_bytes(size_t size, size_t alignment)
+{
+    if (!blocks.empty()) {
+        block const& b = blocks.back();
+        uintptr_t const base = reinterpret_cast<uintptr_t>(b.data.get());
+        size_t const start = ((base + offset + alignment - 1) & ~uintptr_t(alignment - 1)) - base;
+        if (start + size <= b.size) {
+            used_bytes += start + size - offset;
+            offset = start + size;
+            return b.data.get() + start;
+        }
+    }
+
+    // the new block is at least twice as large as the previous one
+    add_block(std::max(size + alignment, blocks.empty() ? size_t(4096) : 2 * blocks.back().size));
+    return allocate_bytes(size, alignment);
+}
+
+void linear_arena::reset()
+{
+    if (blocks.size() > 1) {
+        size_t const total = capacity();
+        blocks.clear();
+        add_block(total);
+    }
+    offset = 0;
+    used_bytes = 0;
+}
+
+size_t linear_arena::capacity() const
+{
+    size_t total = 0;
+    for (block const& b : blocks)
+        total += b.size;
+    return total;
+}
+
+linear_arena& frame_arena()
+{
+    thread_local linear_arena arena;
+    return arena;
+}
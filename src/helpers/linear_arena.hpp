@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Bump allocator: each allocation takes the next bytes of a block, everything is released at once by reset()
+//  - no destructor is called: only for trivially destructible types
+//  - when a block is full a new one is added (the previous allocations stay valid), and reset() merges
+//    them into a single block so that the same sequence of allocations does not allocate again
+struct linear_arena
+{
+    explicit linear_arena(size_t capacity = 0);
+
+    linear_arena(linear_arena const&) = delete;
+    linear_arena& operator=(linear_arena const&) = delete;
+
+    void* allocate_bytes(size_t size, size_t alignment);
+
+    template <typename T>
+    T* allocate(size_t count)
+    {
+        return static_cast<T*>(allocate_bytes(count * sizeof(T), alignof(T)));
+    }
+
+    void reset();
+
+    size_t used() const { return used_bytes; }
+    size_t capacity() const;
+    // number of blocks requested to the system since the creation of the arena
+    size_t block_allocations() const { return nb_block_allocations; }
+
+private:
+    struct block
+    {
+        std::unique_ptr<unsigned char[]> data;
+        size_t size;
+    };
+    void add_block(size_t size);
+
+    std::vector<block> blocks;
+    size_t offset = 0; // in the last block
+    size_t used_bytes = 0;
+    size_t nb_block_allocations = 0;
+};
+
+// Arena of the frame being computed by the calling thread (one per thread)
+// The thread running a frame loop resets it at the beginning of each frame: what is allocated in it lives until then
+// After the first frames it has grown to the size of a frame, and allocating from it no longer touches the heap
+linear_arena& frame_arena();
+
+// STL allocator taking its memory from an arena: deallocate() does nothing, the memory is released by reset()
+template <typename T>
+struct arena_allocator
+{
+    typedef T value_type;
+
+    explicit arena_allocator(linear_arena& arena) : arena(&arena) {}
+    template <typename U>
+    arena_allocator(arena_allocator<U> const& other) : arena(other.arena) {}
+
+    T* allocate(size_t count) { return arena->allocate<T>(count); }
+    void deallocate(T*, size_t) {}
+
+    linear_arena* arena;
+};
+
+template <typename T, typename U>
+bool operator==(arena_allocator<T> const& a, arena_allocator<U> const& b) { return a.arena == b.arena; }
+template <typename T, typename U>
+bool operator!=(arena_allocator<T> const& a, arena_allocator<U> const& b) { return a.arena != b.arena; }
+
+template <typename T>
+using arena_vector = std::vector<T, arena_allocator<T>>;
@@ -0,0 +1,100 @@
+#include "mapped_file.hpp"
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <direct.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+
+mapped_file::~mapped_file()
+{
+    close();
+}
+
+#ifdef _WIN32
+
+bool mapped_file::open(std::string const& filename)
+{
+    close();
+    file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        file = nullptr;
+        return false;
+    }
+    LARGE_INTEGER file_size;
+    GetFileSizeEx(file, &file_size);
+    size = size_t(file_size.QuadPart);
+    mapping = size > 0 ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+    data = mapping != nullptr ? static_cast<unsigned char const*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+    if (data == nullptr) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void mapped_file::close()
+{
+    if (data != nullptr) UnmapViewOfFile(data);
+    if (mapping != nullptr) CloseHandle(mapping);
+    if (file != nullptr) CloseHandle(file);
+    data = nullptr;
+    mapping = nullptr;
+    file = nullptr;
+    size = 0;
+}
+
+#else
+
+bool mapped_file::open(std::string const& filename)
+{
+    close();
+    int const fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+    void* const address = mmap(nullptr, size_t(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);   // the mapping keeps its own reference on the file
+    if (address == MAP_FAILED)
+        return false;
+    data = static_cast<unsigned char const*>(address);
+    size = size_t(info.st_size);
+    return true;
+}
+
+void mapped_file::close()
+{
+    if (data != nullptr)
+        munmap(const_cast<unsigned char*>(data), size);
+    data = nullptr;
+    size = 0;
+}
+
+#endif
+
+long long file_modification_time(std::string const& filename)
+{
+    struct stat info;
+    if (stat(filename.c_str(), &info) != 0)
+        return 0;
+    return static_cast<long long>(info.st_mtime);
+}
+
+void make_directory(std::string const& path)
+{
+#ifdef _WIN32
+    _mkdir(path.c_str());
+#else
+    mkdir(path.c_str(), 0755);
+#endif
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Read-only memory mapping of a whole file (mmap on Unix, file mapping on Windows)
+// The content stays valid until the object is destroyed
+struct mapped_file
+{
+    mapped_file() {}
+    ~mapped_file();
+    mapped_file(mapped_file const&) = delete;
+    mapped_file& operator=(mapped_file const&) = delete;
+
+    bool open(std::string const& filename);
+    void close();
+
+    unsigned char const* data = nullptr;
+    size_t size = 0;
+
+private:
+#ifdef _WIN32
+    void* file = nullptr;
+    void* mapping = nullptr;
+#endif
+};
+
+// Last modification time of a file (0 if it does not exist)
+long long file_modification_time(std::string const& filename);
+
+// Create a directory (nothing happens if it already exists)
+void make_directory(std::string const& path);
@@ -0,0 +1,132 @@
+#include "mesh_builder.hpp"
+#include <algorithm>
+#include <atomic>
+
+using namespace vcl;
+
+
+namespace {
+
+std::atomic<size_t> total_parts{ 0 };
+std::atomic<size_t> total_vertices{ 0 };
+std::atomic<size_t> total_allocations{ 0 };
+
+// grow the capacity of b to hold n more elements, counting the reallocations
+template <typename T>
+void grow(buffer<T>& b, size_t n)
+{
+    size_t const needed = b.data.size() + n;
+    if (needed > b.data.capacity()) {
+        b.data.reserve(std::max(needed, 2 * b.data.capacity()));
+        total_allocations++;
+    }
+}
+
+template <typename T>
+void reserve_buffer(buffer<T>& b, size_t n)
+{
+    if (n > b.data.capacity()) {
+        b.data.reserve(n);
+        total_allocations++;
+    }
+}
+
+}
+
+
+void mesh_builder::reserve(size_t nb_vertices, size_t nb_triangles)
+{
+    reserve_buffer(result.position, nb_vertices);
+    reserve_buffer(result.normal, nb_vertices);
+    reserve_buffer(result.color, nb_vertices);
+    reserve_buffer(result.uv, nb_vertices);
+    reserve_buffer(result.connectivity, nb_triangles);
+}
+
+void mesh_builder::append(mesh const& part)
+{
+    append(part, nullptr, { 0,0,0 });
+}
+
+void mesh_builder::append(mesh const& part, vec3 const& translation)
+{
+    append(part, nullptr, translation);
+}
+
+void mesh_builder::append(mesh const& part, rotation const& r, vec3 const& translation)
+{
+    append(part, &r, translation);
+}
+
+void mesh_builder::append(mesh const& part, rotation const* r, vec3 const& translation)
+{
+    size_t const n = part.position.size();
+    size_t const first = result.position.size();
+    unsigned int const offset = unsigned(first);
+
+    grow(result.position, n);
+    grow(result.normal, n);
+    grow(result.color, n);
+    grow(result.uv, n);
+    grow(result.connectivity, part.connectivity.size());
+
+    bool const has_normal = part.normal.size() == n;
+    for (size_t k = 0; k < n; k++) {
+        result.position.data.push_back(r ? (*r) * part.position[k] + translation : part.position[k] + translation);
+        result.normal.data.push_back(has_normal ? (r ? (*r) * part.normal[k] : part.normal[k]) : vec3(0, 0, 1));
+    }
+    if (part.color.size() == n)
+        result.color.data.insert(result.color.data.end(), part.color.data.begin(), part.color.data.end());
+    else
+        result.color.data.resize(first + n, vec3(1, 1, 1));
+    if (part.uv.size() == n)
+        result.uv.data.insert(result.uv.data.end(), part.uv.data.begin(), part.uv.data.end());
+    else
+        result.uv.data.resize(first + n, vec2(0, 0));
+
+    size_t const first_triangle = result.connectivity.size();
+    for (uint3 const& t : part.connectivity.data)
+        result.connectivity.data.push_back(uint3{ t[0] + offset, t[1] + offset, t[2] + offset });
+
+    if (!has_normal)
+        without_normals.push_back({ first, n, first_triangle, part.connectivity.size() });
+
+    total_parts++;
+    total_vertices += n;
+}
+
+mesh mesh_builder::finish()
+{
+    for (part_range const& p : without_normals)
+        compute_normals(ptr(result.position), p.first_vertex, p.nb_vertices, ptr(result.connectivity) + p.first_triangle, p.nb_triangles, ptr(result.normal));
+    without_normals.clear();
+
+    mesh merged = std::move(result);
+    result = mesh();
+    return merged;
+}
+
+void compute_normals(vec3 const* position, size_t first_vertex, size_t nb_vertices, uint3 const* triangles, size_t nb_triangles, vec3* normal)
+{
+    for (size_t k = first_vertex; k < first_vertex + nb_vertices; k++)
+        normal[k] = { 0.0f, 0.0f, 0.0f };
+    for (size_t k = 0; k < nb_triangles; k++) {
+        uint3 const& t = triangles[k];
+        vec3 const face = cross(position[t[1]] - position[t[0]], position[t[2]] - position[t[0]]);
+        float const l = norm(face);
+        if (l > 1e-12f) {
+            normal[t[0]] += face / l;
+            normal[t[1]] += face / l;
+            normal[t[2]] += face / l;
+        }
+    }
+    for (size_t k = first_vertex; k < first_vertex + nb_vertices; k++) {
+        float const l = norm(normal[k]);
+        normal[k] = l > 1e-12f ? normal[k] / l : vec3(0.0f, 0.0f, 1.0f);
+    }
+}
+
+mesh_builder_statistics mesh_builder_report()
+{
+    return { total_parts.load(), total_vertices.load(), total_allocations.load() };
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "vcl/vcl.hpp"
+#include <vector>
+
+// Merge many parts in a single mesh without reallocating the buffers at each part
+//  - reserve() sizes the buffers once when the final size is known
+//  - append() copies a part with an optional rotation then translation applied on the fly
+//  - missing attributes of a part are filled by finish(): normals computed on the part, white color, zero uv
+// Replaces sequences of vcl::mesh::push_back, which grow the five buffers and offset the indices at each call
+
+struct mesh_builder
+{
+    void reserve(size_t nb_vertices, size_t nb_triangles);
+
+    void append(vcl::mesh const& part);
+    void append(vcl::mesh const& part, vcl::vec3 const& translation);
+    void append(vcl::mesh const& part, vcl::rotation const& rotation, vcl::vec3 const& translation = { 0,0,0 });
+
+    // Returns the merged mesh, the builder is empty afterwards
+    vcl::mesh finish();
+
+    size_t vertices() const { return result.position.size(); }
+    size_t triangles() const { return result.connectivity.size(); }
+
+private:
+    void append(vcl::mesh const& part, vcl::rotation const* rotation, vcl::vec3 const& translation);
+
+    struct part_range
+    {
+        size_t first_vertex, nb_vertices;
+        size_t first_triangle, nb_triangles;
+    };
+
+    vcl::mesh result;
+    std::vector<part_range> without_normals;
+};
+
+// Normals of a set of triangles: sum of the unit face normals around each vertex
+// (the triangles use the indices first_vertex .. first_vertex+nb_vertices-1)
+void compute_normals(vcl::vec3 const* position, size_t first_vertex, size_t nb_vertices, vcl::uint3 const* triangles, size_t nb_triangles, vcl::vec3* normal);
+
+// Number of parts merged and of buffer reallocations done by all the builders since the start
+struct mesh_builder_statistics
+{
+    size_t parts;
+    size_t vertices;
+    size_t allocations;
+};
+mesh_builder_statistics mesh_builder_report();
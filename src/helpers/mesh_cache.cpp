@@ -0,0 +1,125 @@
+#include "mesh_cache.hpp"
+#include "hash.hpp"
+#include "mapped_file.hpp"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <thread>
+
+using namespace vcl;
+
+
+namespace {
+
+std::string const cache_directory = "cache/meshes/";
+bool cache_enabled = true;
+
+// the attribute arrays follow the header in this order
+struct mesh_file_header
+{
+    char magic[4];      // "NMSH"
+    uint32_t version;
+    uint32_t position;
+    uint32_t normal;
+    uint32_t color;
+    uint32_t uv;
+    uint32_t connectivity;
+};
+
+template <typename T>
+void write_array(std::ofstream& stream, buffer<T> const& b)
+{
+    stream.write(reinterpret_cast<char const*>(ptr(b)), std::streamsize(b.size() * sizeof(T)));
+}
+
+template <typename T>
+unsigned char const* read_array(unsigned char const* p, buffer<T>& b, uint32_t size)
+{
+    b.resize(size);
+    std::memcpy(ptr(b), p, size * sizeof(T));
+    return p + size * sizeof(T);
+}
+
+}
+
+
+bool save_mesh(std::string const& filename, mesh const& m)
+{
+    mesh_file_header header;
+    std::memcpy(header.magic, "NMSH", 4);
+    header.version = mesh_cache_version;
+    header.position = uint32_t(m.position.size());
+    header.normal = uint32_t(m.normal.size());
+    header.color = uint32_t(m.color.size());
+    header.uv = uint32_t(m.uv.size());
+    header.connectivity = uint32_t(m.connectivity.size());
+
+    // write in a temporary file first so that a concurrent reader never sees a partial file
+    // the name is unique per thread: two threads may generate the same mesh at the same time
+    std::string const temporary = filename + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+    {
+        std::ofstream stream(temporary, std::ios::binary);
+        if (!stream)
+            return false;
+        stream.write(reinterpret_cast<char const*>(&header), sizeof(header));
+        write_array(stream, m.position);
+        write_array(stream, m.normal);
+        write_array(stream, m.color);
+        write_array(stream, m.uv);
+        write_array(stream, m.connectivity);
+        if (!stream)
+            return false;
+    }
+    std::remove(filename.c_str());
+    return std::rename(temporary.c_str(), filename.c_str()) == 0;
+}
+
+bool load_mesh(std::string const& filename, mesh& m)
+{
+    mapped_file file;
+    if (!file.open(filename) || file.size < sizeof(mesh_file_header))
+        return false;
+
+    mesh_file_header header;
+    std::memcpy(&header, file.data, sizeof(header));
+    size_t const expected = sizeof(header) + (size_t(header.position) + header.normal + header.color) * sizeof(vec3)
+                          + size_t(header.uv) * sizeof(vec2) + size_t(header.connectivity) * sizeof(uint3);
+    if (std::memcmp(header.magic, "NMSH", 4) != 0 || header.version != uint32_t(mesh_cache_version) || file.size != expected)
+        return false;
+
+    unsigned char const* p = file.data + sizeof(header);
+    p = read_array(p, m.position, header.position);
+    p = read_array(p, m.normal, header.normal);
+    p = read_array(p, m.color, header.color);
+    p = read_array(p, m.uv, header.uv);
+    read_array(p, m.connectivity, header.connectivity);
+    return true;
+}
+
+void set_mesh_cache_enabled(bool enabled)
+{
+    cache_enabled = enabled;
+}
+
+mesh cached_mesh(std::string const& generator, std::initializer_list<float> parameters, uint64_t seed, std::function<mesh()> const& generate)
+{
+    if (!cache_enabled)
+        return generate();
+
+    uint64_t h = hash_fnv1a(generator);
+    for (float const parameter : parameters)
+        h = hash_fnv1a(&parameter, sizeof(parameter), h);
+    h = hash_fnv1a(&seed, sizeof(seed), h);
+    std::string const filename = cache_directory + generator + "_" + hash_to_string(h) + ".mesh";
+
+    mesh m;
+    if (load_mesh(filename, m))
+        return m;
+
+    m = generate();
+    make_directory("cache");
+    make_directory(cache_directory);
+    save_mesh(filename, m);
+    return m;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "vcl/vcl.hpp"
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+
+// Cache of procedurally generated meshes
+//  - the mesh is stored in cache/meshes/ in a compact binary file, keyed by the generator name,
+//    its parameter values and the seed of its random numbers
+//  - on a hit the file is mapped and copied in the mesh: the generator is not called at all
+//  - increase mesh_cache_version when a generator changes to invalidate the files
+
+int const mesh_cache_version = 5;
+
+vcl::mesh cached_mesh(std::string const& generator, std::initializer_list<float> parameters, uint64_t seed, std::function<vcl::mesh()> const& generate);
+
+// When disabled, cached_mesh() always calls the generator and writes nothing (benchmarks of the generators)
+void set_mesh_cache_enabled(bool enabled);
+
+bool save_mesh(std::string const& filename, vcl::mesh const& m);
+bool load_mesh(std::string const& filename, vcl::mesh& m);
@@ -0,0 +1,111 @@
+#include "noise.hpp"
+#include <cmath>
+
+using namespace vcl;
+
+
+namespace {
+
+// reference permutation of the improved noise (Ken Perlin, 2002), repeated twice so that p[p[X] + Y + 1] needs no wrap
+struct permutation_table
+{
+    unsigned char p[512];
+
+    permutation_table()
+    {
+        static unsigned char const reference[256] = {
+            151, 160, 137, 91, 90, 15, 131, 13, 201, 95, 96, 53, 194, 233, 7, 225,
+            140, 36, 103, 30, 69, 142, 8, 99, 37, 240, 21, 10, 23, 190, 6, 148,
+            247, 120, 234, 75, 0, 26, 197, 62, 94, 252, 219, 203, 117, 35, 11, 32,
+            57, 177, 33, 88, 237, 149, 56, 87, 174, 20, 125, 136, 171, 168, 68, 175,
+            74, 165, 71, 134, 139, 48, 27, 166, 77, 146, 158, 231, 83, 111, 229, 122,
+            60, 211, 133, 230, 220, 105, 92, 41, 55, 46, 245, 40, 244, 102, 143, 54,
+            65, 25, 63, 161, 1, 216, 80, 73, 209, 76, 132, 187, 208, 89, 18, 169,
+            200, 196, 135, 130, 116, 188, 159, 86, 164, 100, 109, 198, 173, 186, 3, 64,
+            52, 217, 226, 250, 124, 123, 5, 202, 38, 147, 118, 126, 255, 82, 85, 212,
+            207, 206, 59, 227, 47, 16, 58, 17, 182, 189, 28, 42, 223, 183, 170, 213,
+            119, 248, 152, 2, 44, 154, 163, 70, 221, 153, 101, 155, 167, 43, 172, 9,
+            129, 22, 39, 253, 19, 98, 108, 110, 79, 113, 224, 232, 178, 185, 112, 104,
+            218, 246, 97, 228, 251, 34, 242, 193, 238, 210, 144, 12, 191, 179, 162, 241,
+            81, 51, 145, 235, 249, 14, 239, 107, 49, 192, 214, 31, 181, 199, 106, 157,
+            184, 84, 204, 176, 115, 121, 50, 45, 127, 4, 150, 254, 138, 236, 205, 93,
+            222, 114, 67, 29, 24, 72, 243, 141, 128, 195, 78, 66, 215, 61, 156, 180,
+        };
+        for (int k = 0; k < 256; k++)
+            p[k] = p[256 + k] = reference[k];
+    }
+};
+
+permutation_table const& permutation()
+{
+    static permutation_table const table;
+    return table;
+}
+
+// (x,y) components of the 16 gradients of the reference grad(hash, x, y, z) at z = 0:
+//  u = h<8 ? x : y, v = h<4 ? y : (h==12 || h==14 ? x : z), signs given by the bits 0 and 1 of the hash
+float const gradient_x[16] = { 1,-1, 1,-1, 1,-1, 1,-1, 0, 0, 0, 0, 1, 0,-1, 0 };
+float const gradient_y[16] = { 1, 1,-1,-1, 0, 0, 0, 0, 1,-1, 1,-1, 1,-1, 1,-1 };
+
+inline vec2 corner_gradient(int hash)
+{
+    int const k = hash & 15;
+    return { gradient_x[k], gradient_y[k] };
+}
+
+inline float fade(float t)
+{
+    return t * t * t * (t * (t * 6.0f - 15.0f) + 10.0f);
+}
+
+inline float fade_derivative(float t)
+{
+    return 30.0f * t * t * (t * (t - 2.0f) + 1.0f);
+}
+
+}
+
+
+noise_sample perlin_gradient(vec2 const& p)
+{
+    float const fx = std::floor(p.x), fy = std::floor(p.y);
+    int const X = int(fx) & 255, Y = int(fy) & 255;
+    float const x = p.x - fx, y = p.y - fy;
+
+    unsigned char const* perm = permutation().p;
+    vec2 const ga = corner_gradient(perm[perm[perm[X] + Y]]);
+    vec2 const gb = corner_gradient(perm[perm[perm[X + 1] + Y]]);
+    vec2 const gc = corner_gradient(perm[perm[perm[X] + Y + 1]]);
+    vec2 const gd = corner_gradient(perm[perm[perm[X + 1] + Y + 1]]);
+
+    float const va = ga.x * x + ga.y * y;
+    float const vb = gb.x * (x - 1) + gb.y * y;
+    float const vc = gc.x * x + gc.y * (y - 1);
+    float const vd = gd.x * (x - 1) + gd.y * (y - 1);
+
+    // bilinear blend of the corner values with the fade weights, differentiated term by term
+    float const sx = fade(x), sy = fade(y);
+    float const dsx = fade_derivative(x), dsy = fade_derivative(y);
+    float const k = va - vb - vc + vd;
+
+    noise_sample sample;
+    sample.value = va + sx * (vb - va) + sy * (vc - va) + sx * sy * k;
+    sample.gradient = ga + sx * (gb - ga) + sy * (gc - ga) + sx * sy * (ga - gb - gc + gd)
+        + vec2(dsx * (vb - va + sy * k), dsy * (vc - va + sx * k));
+    return sample;
+}
+
+noise_sample noise_perlin_gradient(vec2 const& p, int octave, float persistency, float frequency_gain)
+{
+    noise_sample sum = { 0.0f, { 0.0f, 0.0f } };
+    float a = 1.0f;     // magnitude of the octave
+    float f = 1.0f;     // frequency of the octave
+    for (int k = 0; k < octave; k++) {
+        noise_sample const n = perlin_gradient(f * p);
+        sum.value += a * (0.5f + 0.5f * n.value);
+        sum.gradient = sum.gradient + (0.5f * a * f) * n.gradient;
+        f *= frequency_gain;
+        a *= persistency;
+    }
+    return sum;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "vcl/vcl.hpp"
+
+// Perlin noise evaluated together with its analytic gradient
+//  - improved Perlin noise (reference permutation and gradients, quintic fade) sliced at z = 0: same values as vcl::noise_perlin
+//  - the gradient is exact: normals of a height field built from it need no pass over the mesh
+struct noise_sample
+{
+    float value;
+    vcl::vec2 gradient;     // (d/dx, d/dy)
+};
+
+// Single octave, value in [-1,1]
+noise_sample perlin_gradient(vcl::vec2 const& p);
+
+// Same sum of octaves as vcl::noise_perlin: sum_k persistency^k * (0.5 + 0.5 * noise(frequency_gain^k * p))
+noise_sample noise_perlin_gradient(vcl::vec2 const& p, int octave, float persistency, float frequency_gain);
+
+// Unit normal of the height field z(x,y) whose gradient is given
+inline vcl::vec3 normal_from_gradient(vcl::vec2 const& gradient)
+{
+    return vcl::normalize(vcl::vec3(-gradient.x, -gradient.y, 1.0f));
+}
@@ -0,0 +1,199 @@
+#include "poisson_disk.hpp"
+#include "random.hpp"
+#include <algorithm>
+#include <cmath>
+
+using namespace vcl;
+
+
+namespace {
+
+struct poisson_grid
+{
+    vec2 origin;
+    float cell;
+    int nx, ny;
+    // at most one sample per cell since the cell diagonal is the minimal distance
+    struct cell_sample
+    {
+        vec2 point;
+        float radius; // 0 for an empty cell
+    };
+    std::vector<cell_sample> cells;
+};
+
+struct poisson_tile
+{
+    int x0, y0, x1, y1; // range of cells [x0,x1) x [y0,y1)
+};
+
+float local_radius(poisson_disk_parameters const& parameters, vec2 const& p)
+{
+    if (!parameters.density)
+        return parameters.radius;
+    float const d = std::min(std::max(parameters.density(p), std::max(parameters.density_min, poisson_density_floor)), 1.0f);
+    return parameters.radius / std::sqrt(d);
+}
+
+// cells around a sample that may hold a sample closer than the largest local distance,
+// nearest first so that rejected candidates are found early
+struct cell_offset
+{
+    int x, y;
+};
+
+std::vector<cell_offset> neighbour_offsets(int range, float cell, float radius_max)
+{
+    std::vector<cell_offset> offsets;
+    std::vector<float> distances;
+    for (int y = -range; y <= range; y++) {
+        for (int x = -range; x <= range; x++) {
+            float const dx = std::max(std::abs(x) - 1, 0) * cell, dy = std::max(std::abs(y) - 1, 0) * cell;
+            if (dx * dx + dy * dy < radius_max * radius_max) {
+                offsets.push_back({ x, y });
+                distances.push_back(dx * dx + dy * dy + 1e-3f * cell * cell * (x * x + y * y));
+            }
+        }
+    }
+    std::vector<size_t> order(offsets.size());
+    for (size_t k = 0; k < order.size(); k++)
+        order[k] = k;
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return distances[a] < distances[b]; });
+    std::vector<cell_offset> sorted;
+    for (size_t k : order)
+        sorted.push_back(offsets[k]);
+    return sorted;
+}
+
+// try to insert p in the grid, p must be in the tile
+bool insert_sample(poisson_grid& grid, poisson_disk_parameters const& parameters, std::vector<cell_offset> const& offsets, vec2 const& p)
+{
+    if (parameters.accept && !parameters.accept(p))
+        return false;
+
+    float const r = local_radius(parameters, p);
+    int const cx = std::min(int((p.x - grid.origin.x) / grid.cell), grid.nx - 1);
+    int const cy = std::min(int((p.y - grid.origin.y) / grid.cell), grid.ny - 1);
+
+    for (cell_offset const& o : offsets) {
+        int const x = cx + o.x, y = cy + o.y;
+        if (x < 0 || y < 0 || x >= grid.nx || y >= grid.ny)
+            continue;
+        poisson_grid::cell_sample const& q = grid.cells[y * grid.nx + x];
+        if (q.radius > 0) {
+            float const dx = q.point.x - p.x, dy = q.point.y - p.y;
+            float const dmin = std::max(r, q.radius);
+            if (dx * dx + dy * dy < dmin * dmin)
+                return false;
+        }
+    }
+
+    grid.cells[cy * grid.nx + cx] = { p, r };
+    return true;
+}
+
+void sample_tile(poisson_grid& grid, poisson_disk_parameters const& parameters, std::vector<cell_offset> const& offsets, poisson_tile const& tile, rng_stream& rng, std::vector<vec2>& samples)
+{
+    vec2 const p_min = grid.origin + grid.cell * vec2(float(tile.x0), float(tile.y0));
+    // the last cells go past the domain: the tiles are cut at its border
+    vec2 const p_max = { std::min(grid.origin.x + grid.cell * float(tile.x1), parameters.domain_max.x),
+                         std::min(grid.origin.y + grid.cell * float(tile.y1), parameters.domain_max.y) };
+    auto inside = [&](vec2 const& p) { return p.x >= p_min.x && p.y >= p_min.y && p.x < p_max.x && p.y < p_max.y; };
+
+    std::vector<vec2> active;
+    std::vector<float> active_radius;
+    float const step_cos = std::cos(6.2831853f / parameters.candidates);
+    float const step_sin = std::sin(6.2831853f / parameters.candidates);
+
+    // new random starting points until several of them fail in a row (the region can be split by the mask)
+    int const max_failures = 30;
+    int failures = 0;
+    while (failures < max_failures) {
+        vec2 const seed = { rng_uniform(rng, p_min.x, p_max.x), rng_uniform(rng, p_min.y, p_max.y) };
+        if (!inside(seed) || !insert_sample(grid, parameters, offsets, seed)) {
+            failures++;
+            continue;
+        }
+        failures = 0;
+        samples.push_back(seed);
+        active.push_back(seed);
+        active_radius.push_back(local_radius(parameters, seed));
+
+        // Bridson: candidates around a random active sample
+        // they are spread regularly on the circle of radius r (starting at a random angle) rather than
+        // drawn in the annulus [r,2r]: fewer rejected candidates and a denser packing
+        while (!active.empty()) {
+            size_t const k = std::min(size_t(rng_uniform(rng) * active.size()), active.size() - 1);
+            vec2 const center = active[k];
+            float const r = active_radius[k] * 1.001f;
+            float const angle = rng_uniform(rng, 0.0f, 6.2831853f);
+            vec2 direction = { std::cos(angle), std::sin(angle) };
+            bool found = false;
+            for (int c = 0; c < parameters.candidates && !found; c++) {
+                vec2 const p = center + r * direction;
+                direction = { step_cos * direction.x - step_sin * direction.y, step_sin * direction.x + step_cos * direction.y };
+                if (inside(p) && insert_sample(grid, parameters, offsets, p)) {
+                    samples.push_back(p);
+                    active.push_back(p);
+                    active_radius.push_back(local_radius(parameters, p));
+                    found = true;
+                }
+            }
+            if (!found) {
+                active[k] = active.back();
+                active_radius[k] = active_radius.back();
+                active.pop_back();
+                active_radius.pop_back();
+            }
+        }
+    }
+}
+
+}
+
+
+std::vector<vec2> poisson_disk_sample(poisson_disk_parameters const& parameters, thread_pool& pool)
+{
+    poisson_grid grid;
+    grid.origin = parameters.domain_min;
+    grid.cell = parameters.radius / std::sqrt(2.0f);
+    vec2 const extent = parameters.domain_max - parameters.domain_min;
+    grid.nx = std::max(int(std::ceil(extent.x / grid.cell)), 1);
+    grid.ny = std::max(int(std::ceil(extent.y / grid.cell)), 1);
+    grid.cells.assign(size_t(grid.nx) * grid.ny, poisson_grid::cell_sample{ { 0.0f, 0.0f }, 0.0f });
+
+    // number of cells to look at around a sample, given the largest local distance
+    float const radius_max = parameters.density ? parameters.radius / std::sqrt(std::max(parameters.density_min, poisson_density_floor)) : parameters.radius;
+    int const range = int(std::ceil(radius_max / grid.cell));
+    std::vector<cell_offset> const offsets = neighbour_offsets(range, grid.cell, radius_max);
+
+    // tiles wider than the search range: tiles of the same color never share a cell read by both
+    int const tile_size = std::max(range + 1, 32);
+    int const tiles_x = (grid.nx + tile_size - 1) / tile_size;
+    int const tiles_y = (grid.ny + tile_size - 1) / tile_size;
+    std::vector<std::vector<vec2>> samples(size_t(tiles_x) * tiles_y);
+
+    for (int color = 0; color < 4; color++) {
+        std::vector<int> tiles;
+        for (int ty = color / 2; ty < tiles_y; ty += 2)
+            for (int tx = color % 2; tx < tiles_x; tx += 2)
+                tiles.push_back(ty * tiles_x + tx);
+
+        parallel_for(pool, tiles.size(), [&](size_t k) {
+            int const id = tiles[k];
+            int const tx = id % tiles_x, ty = id / tiles_x;
+            poisson_tile const tile = { tx * tile_size, ty * tile_size, std::min((tx + 1) * tile_size, grid.nx), std::min((ty + 1) * tile_size, grid.ny) };
+            rng_stream rng = rng_create(parameters.name.c_str(), uint64_t(id));
+            sample_tile(grid, parameters, offsets, tile, rng, samples[id]);
+        });
+    }
+
+    size_t total = 0;
+    for (auto const& s : samples)
+        total += s.size();
+    std::vector<vec2> result;
+    result.reserve(total);
+    for (auto const& s : samples)
+        result.insert(result.end(), s.begin(), s.end());
+    return result;
+}
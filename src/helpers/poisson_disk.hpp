@@ -0,0 +1,31 @@
+#pragma once
+
+#include "vcl/vcl.hpp"
+#include "thread_pool.hpp"
+#include <functional>
+#include <string>
+#include <vector>
+
+// Poisson-disk sampling of a rectangle (Bridson), accelerated by a background grid
+//  - the local distance between two samples is radius/sqrt(density(p)), density in [density_min, 1];
+//    density_min is raised to poisson_density_floor, so that the largest distance (and the search range) stays finite
+//  - the samples are only kept where accept(p) is true
+//  - the domain is cut in tiles processed in parallel: 4 passes over the tiles, in a checkerboard,
+//    so that two tiles processed at the same time never read the same cells of the grid
+// The result only depends on the parameters and the random seed, not on the number of threads
+
+struct poisson_disk_parameters
+{
+    vcl::vec2 domain_min;
+    vcl::vec2 domain_max;
+    float radius = 1.0f;
+    float density_min = 0.1f;
+    std::function<float(vcl::vec2 const&)> density; // empty: uniform density
+    std::function<bool(vcl::vec2 const&)> accept;   // empty: the whole domain
+    int candidates = 20;                            // tries around each active sample before it is discarded
+    std::string name = "poisson_disk";              // name of the random streams
+};
+
+float const poisson_density_floor = 0.01f;     // largest distance: 10 x radius
+
+std::vector<vcl::vec2> poisson_disk_sample(poisson_disk_parameters const& parameters, thread_pool& pool);
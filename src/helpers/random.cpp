@@ -0,0 +1,65 @@
+#include "random.hpp"
+#include "hash.hpp"
+#include <atomic>
+#include <cstring>
+
+using namespace vcl;
+
+
+static std::atomic<uint64_t> global_seed(0x4e696c65u);
+
+void rng_set_global_seed(uint64_t seed)
+{
+    global_seed = seed;
+}
+
+uint64_t rng_global_seed()
+{
+    return global_seed;
+}
+
+// splitmix64: spreads a 64 bits key into well mixed state words
+static uint64_t splitmix64(uint64_t& x)
+{
+    uint64_t z = (x += 0x9e3779b97f4a7c15u);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9u;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebu;
+    return z ^ (z >> 31);
+}
+
+rng_stream rng_create(uint64_t seed, char const* subsystem, uint64_t entity)
+{
+    // hash of the subsystem name combined with the seed and the entity index
+    uint64_t key = hash_fnv1a(subsystem, std::strlen(subsystem));
+    key ^= seed;
+    splitmix64(key);
+    key ^= entity * 0xd6e8feb86659fd93u;
+
+    rng_stream rng;
+    uint64_t const a = splitmix64(key);
+    uint64_t const b = splitmix64(key);
+    rng.s[0] = uint32_t(a);
+    rng.s[1] = uint32_t(a >> 32);
+    rng.s[2] = uint32_t(b);
+    rng.s[3] = uint32_t(b >> 32);
+    if ((rng.s[0] | rng.s[1] | rng.s[2] | rng.s[3]) == 0)   // the all-zero state is a fixed point
+        rng.s[0] = 1;
+    return rng;
+}
+
+rng_stream rng_create(char const* subsystem, uint64_t entity)
+{
+    return rng_create(rng_global_seed(), subsystem, entity);
+}
+
+void rng_fill_uniform(rng_stream& rng, float* values, size_t n, float a, float b)
+{
+    float const scale = (b - a) * (1.0f / 16777216.0f);
+    for (size_t k = 0; k < n; ++k)
+        values[k] = a + scale * (rng_next(rng) >> 8);
+}
+
+void rng_fill_uniform(rng_stream& rng, buffer<float>& values, float a, float b)
+{
+    rng_fill_uniform(rng, ptr(values), values.size(), a, b);
+}
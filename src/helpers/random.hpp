@@ -0,0 +1,50 @@
+#pragma once
+
+#include "vcl/vcl.hpp"
+#include <cstdint>
+
+// Random number streams (xoshiro128+) replacing rand()
+//  - one stream per subsystem and per entity, derived from a global seed: results do not depend on call order
+//  - a stream is a plain value owned by its user: no lock, can be used from worker threads
+struct rng_stream
+{
+    uint32_t s[4];
+};
+
+// Global seed from which every stream is derived (set once at startup, e.g. from the command line)
+void rng_set_global_seed(uint64_t seed);
+uint64_t rng_global_seed();
+
+// Create the stream of a given subsystem (e.g. "palm_tree") and entity index
+rng_stream rng_create(char const* subsystem, uint64_t entity = 0);
+rng_stream rng_create(uint64_t seed, char const* subsystem, uint64_t entity);
+
+inline uint32_t rng_next(rng_stream& rng)
+{
+    uint32_t* s = rng.s;
+    uint32_t const result = s[0] + s[3];
+    uint32_t const t = s[1] << 9;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = (s[3] << 11) | (s[3] >> 21);
+    return result;
+}
+
+// Uniform float in [0,1[ (the 24 upper bits fill the mantissa)
+inline float rng_uniform(rng_stream& rng)
+{
+    return (rng_next(rng) >> 8) * (1.0f / 16777216.0f);
+}
+
+// Uniform float in [a,b[
+inline float rng_uniform(rng_stream& rng, float a, float b)
+{
+    return a + (b - a) * rng_uniform(rng);
+}
+
+// Batch generation of n uniform floats in [a,b[
+void rng_fill_uniform(rng_stream& rng, float* values, size_t n, float a = 0.0f, float b = 1.0f);
+void rng_fill_uniform(rng_stream& rng, vcl::buffer<float>& values, float a = 0.0f, float b = 1.0f);
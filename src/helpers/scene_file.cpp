@@ -0,0 +1,311 @@
+#include "scene_file.hpp"
+#include "hash.hpp"
+#include "mapped_file.hpp"
+#include "../items/terrain.hpp"
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+using namespace vcl;
+
+
+namespace {
+
+char const* const type_names[prop_type_count] = { "pyramid", "palm_tree", "column", "obelisque", "fern" };
+
+// binary form: header, then per type position[count], height[count], rotation[count]
+struct scene_file_header
+{
+    char magic[4];      // "NSCN"
+    uint32_t version;
+    float size[prop_type_count];
+    int32_t scatter[prop_type_count];
+    uint32_t count[prop_type_count];
+};
+uint32_t const scene_file_version = 1;
+
+// minimal tokenizer working directly on the mapped file (no copy of the lines)
+struct scene_parser
+{
+    char const* p;
+    char const* end;
+    int line;
+};
+
+bool is_blank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+void skip_blanks(scene_parser& in)
+{
+    while (in.p < in.end && is_blank(*in.p))
+        ++in.p;
+}
+
+void skip_line(scene_parser& in)
+{
+    while (in.p < in.end && *in.p != '\n')
+        ++in.p;
+    if (in.p < in.end)
+        ++in.p;
+    in.line++;
+}
+
+bool end_of_line(scene_parser& in)
+{
+    skip_blanks(in);
+    return in.p == in.end || *in.p == '\n' || *in.p == '#';
+}
+
+bool read_word(scene_parser& in, char const*& word, size_t& length)
+{
+    skip_blanks(in);
+    word = in.p;
+    while (in.p < in.end && !is_blank(*in.p) && *in.p != '\n' && *in.p != '#')
+        ++in.p;
+    length = size_t(in.p - word);
+    return length > 0;
+}
+
+bool word_is(char const* word, size_t length, char const* s)
+{
+    return std::strlen(s) == length && std::strncmp(word, s, length) == 0;
+}
+
+int read_type(scene_parser& in)
+{
+    char const* word;
+    size_t length;
+    if (!read_word(in, word, length))
+        return -1;
+    for (int k = 0; k < prop_type_count; k++)
+        if (word_is(word, length, type_names[k]))
+            return k;
+    return -1;
+}
+
+// decimal number with optional sign, fraction and exponent
+bool read_float(scene_parser& in, float& value)
+{
+    skip_blanks(in);
+    char const* p = in.p;
+    double sign = 1.0;
+    if (p < in.end && (*p == '-' || *p == '+')) {
+        if (*p == '-') sign = -1.0;
+        ++p;
+    }
+    double x = 0.0;
+    bool digits = false;
+    while (p < in.end && *p >= '0' && *p <= '9') {
+        x = 10.0 * x + (*p++ - '0');
+        digits = true;
+    }
+    if (p < in.end && *p == '.') {
+        ++p;
+        double scale = 0.1;
+        while (p < in.end && *p >= '0' && *p <= '9') {
+            x += scale * (*p++ - '0');
+            scale *= 0.1;
+            digits = true;
+        }
+    }
+    if (!digits)
+        return false;
+    if (p < in.end && (*p == 'e' || *p == 'E')) {
+        ++p;
+        int exponent_sign = 1, exponent = 0;
+        if (p < in.end && (*p == '-' || *p == '+')) {
+            if (*p == '-') exponent_sign = -1;
+            ++p;
+        }
+        while (p < in.end && *p >= '0' && *p <= '9')
+            exponent = 10 * exponent + (*p++ - '0');
+        x *= std::pow(10.0, exponent_sign * exponent);
+    }
+    value = float(sign * x);
+    in.p = p;
+    return true;
+}
+
+bool parse_line(scene_parser& in, scene_description& scene)
+{
+    char const* word;
+    size_t length;
+    if (!read_word(in, word, length))
+        return true; // empty line or comment
+
+    int const type = read_type(in);
+    if (type < 0)
+        return false;
+
+    if (word_is(word, length, "prop"))
+        return read_float(in, scene.size[type]);
+
+    if (word_is(word, length, "scatter")) {
+        float count;
+        if (!read_float(in, count))
+            return false;
+        scene.scatter[type] = int(count);
+        return true;
+    }
+
+    if (word_is(word, length, "place")) {
+        float x, y, h, dz, r;
+        if (!read_float(in, x) || !read_float(in, y) || !read_float(in, h) || !read_float(in, dz) || !read_float(in, r))
+            return false;
+        scene.position[type].push_back({ x, y, dz });
+        scene.height[type].push_back(h);
+        scene.rotation[type].push_back(r);
+        return true;
+    }
+
+    return false;
+}
+
+bool load_scene_text(mapped_file const& file, std::string const& filename, scene_description& scene)
+{
+    scene_parser in = { reinterpret_cast<char const*>(file.data), reinterpret_cast<char const*>(file.data) + file.size, 1 };
+    bool valid = true;
+    while (in.p < in.end) {
+        if (!parse_line(in, scene) || !end_of_line(in)) {
+            std::cerr << filename << ":" << in.line << ": invalid scene directive" << std::endl;
+            valid = false;
+        }
+        skip_line(in);
+    }
+    return valid;
+}
+
+template <typename T>
+unsigned char const* read_array(unsigned char const* p, std::vector<T>& v, uint32_t count)
+{
+    v.resize(count);
+    if (count > 0)
+        std::memcpy(&v[0], p, count * sizeof(T));
+    return p + count * sizeof(T);
+}
+
+bool load_scene_binary(mapped_file const& file, scene_description& scene)
+{
+    if (file.size < sizeof(scene_file_header))
+        return false;
+    scene_file_header header;
+    std::memcpy(&header, file.data, sizeof(header));
+    if (header.version != scene_file_version)
+        return false;
+
+    size_t expected = sizeof(header);
+    for (int k = 0; k < prop_type_count; k++)
+        expected += size_t(header.count[k]) * (sizeof(vec3) + 2 * sizeof(float));
+    if (file.size != expected)
+        return false;
+
+    unsigned char const* p = file.data + sizeof(header);
+    for (int k = 0; k < prop_type_count; k++) {
+        scene.size[k] = header.size[k];
+        scene.scatter[k] = header.scatter[k];
+        p = read_array(p, scene.position[k], header.count[k]);
+        p = read_array(p, scene.height[k], header.count[k]);
+        p = read_array(p, scene.rotation[k], header.count[k]);
+    }
+    return true;
+}
+
+template <typename T>
+void write_array(std::ofstream& stream, std::vector<T> const& v)
+{
+    if (!v.empty())
+        stream.write(reinterpret_cast<char const*>(&v[0]), std::streamsize(v.size() * sizeof(T)));
+}
+
+}
+
+
+char const* prop_type_name(int type)
+{
+    return type_names[type];
+}
+
+void clear(scene_description& scene)
+{
+    scene = scene_description();
+}
+
+size_t placement_count(scene_description const& scene)
+{
+    size_t count = 0;
+    for (int k = 0; k < prop_type_count; k++)
+        count += scene.position[k].size();
+    return count;
+}
+
+bool load_scene(std::string const& filename, scene_description& scene)
+{
+    mapped_file file;
+    if (!file.open(filename)) {
+        std::cerr << "Cannot open scene file " << filename << std::endl;
+        return false;
+    }
+    clear(scene);
+    if (file.size >= 4 && std::memcmp(file.data, "NSCN", 4) == 0)
+        return load_scene_binary(file, scene);
+    return load_scene_text(file, filename, scene);
+}
+
+bool save_scene_binary(std::string const& filename, scene_description const& scene)
+{
+    scene_file_header header;
+    std::memcpy(header.magic, "NSCN", 4);
+    header.version = scene_file_version;
+    for (int k = 0; k < prop_type_count; k++) {
+        header.size[k] = scene.size[k];
+        header.scatter[k] = scene.scatter[k];
+        header.count[k] = uint32_t(scene.position[k].size());
+    }
+
+    std::string const temporary = filename + ".tmp";
+    {
+        std::ofstream stream(temporary, std::ios::binary);
+        if (!stream)
+            return false;
+        stream.write(reinterpret_cast<char const*>(&header), sizeof(header));
+        for (int k = 0; k < prop_type_count; k++) {
+            write_array(stream, scene.position[k]);
+            write_array(stream, scene.height[k]);
+            write_array(stream, scene.rotation[k]);
+        }
+        if (!stream)
+            return false;
+    }
+    std::remove(filename.c_str());
+    return std::rename(temporary.c_str(), filename.c_str()) == 0;
+}
+
+bool load_scene_cached(std::string const& filename, scene_description& scene)
+{
+    std::string const binary = "cache/scenes/" + hash_to_string(hash_fnv1a(filename)) + ".bin";
+    long long const source_time = file_modification_time(filename);
+    if (source_time == 0)
+        return load_scene(filename, scene);
+
+    if (file_modification_time(binary) >= source_time && load_scene(binary, scene))
+        return true;
+
+    if (!load_scene(filename, scene))
+        return false;
+    make_directory("cache");
+    make_directory("cache/scenes");
+    save_scene_binary(binary, scene);
+    return true;
+}
+
+void resolve_scene_heights(scene_description& scene, float terrain_height)
+{
+    for (int k = 0; k < prop_type_count; k++) {
+        for (size_t i = 0; i < scene.position[k].size(); i++) {
+            vec3& p = scene.position[k][i];
+            p.z += scene.height[k][i] * terrain_height + evaluate_dune(p.x, p.y, terrain_height);
+        }
+    }
+}
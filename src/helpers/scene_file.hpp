@@ -0,0 +1,41 @@
+#pragma once
+
+#include "vcl/vcl.hpp"
+#include <string>
+#include <vector>
+
+// Description of the props placed in the scene, read from a scene file
+//
+// Text form (for authoring), one directive per line, '#' starts a comment:
+//   prop <type> <size>                         parameter of the generator of the type
+//   scatter <type> <count>                     number of procedurally placed instances
+//   place <type> <x> <y> <height> <dz> <rotation>
+// The altitude of a placement is height*terrain_height + dune(x,y) + dz, resolved after loading
+//
+// Binary form (for loading): header, then for each type the arrays of its placements
+// load_scene() reads both forms, load_scene_cached() keeps a binary copy in cache/scenes/
+
+enum prop_type { prop_pyramid, prop_palm_tree, prop_column, prop_obelisque, prop_fern, prop_type_count };
+
+char const* prop_type_name(int type);
+
+struct scene_description
+{
+    float size[prop_type_count] = {};
+    int scatter[prop_type_count] = {};
+
+    // placements stored by type (structure of arrays)
+    std::vector<vcl::vec3> position[prop_type_count]; // (x, y, dz) before resolution, (x, y, z) after
+    std::vector<float> height[prop_type_count];
+    std::vector<float> rotation[prop_type_count];
+};
+
+void clear(scene_description& scene);
+size_t placement_count(scene_description const& scene);
+
+bool load_scene(std::string const& filename, scene_description& scene);
+bool load_scene_cached(std::string const& filename, scene_description& scene);
+bool save_scene_binary(std::string const& filename, scene_description const& scene);
+
+// Compute the altitude of the placements once the terrain is known
+void resolve_scene_heights(scene_description& scene, float terrain_height);
@@ -0,0 +1,193 @@
+#include "shader_cache.hpp"
+#include "hash.hpp"
+#include "mapped_file.hpp"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+using namespace vcl;
+
+
+namespace {
+
+struct watched_program
+{
+    GLuint program;
+    shader_source vertex;
+    shader_source fragment;
+    long long vertex_time;
+    long long fragment_time;
+};
+
+std::vector<watched_program> watched;
+
+std::string const cache_directory = "cache/shaders/";
+
+std::string driver_string()
+{
+    std::string s;
+    for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION }) {
+        GLubyte const* value = glGetString(name);
+        s += value != nullptr ? reinterpret_cast<char const*>(value) : "";
+        s += '\n';
+    }
+    return s;
+}
+
+std::string cache_filename(shader_source const& vertex, shader_source const& fragment)
+{
+    static std::string const driver = driver_string();
+    uint64_t h = hash_fnv1a(driver);
+    h = hash_fnv1a(vertex.text, h);
+    h = hash_fnv1a("\n--- fragment ---\n", h);
+    h = hash_fnv1a(fragment.text, h);
+    return cache_directory + hash_to_string(h) + ".bin";
+}
+
+GLuint compile_shader(GLenum type, shader_source const& source)
+{
+    GLuint const shader = glCreateShader(type);
+    char const* text = source.text.c_str();
+    glShaderSource(shader, 1, &text, nullptr);
+    glCompileShader(shader);
+
+    GLint status = GL_FALSE;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+    if (status != GL_TRUE) {
+        char log[2048];
+        glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+        std::cerr << "Shader compilation failed (" << (source.filename.empty() ? "preset" : source.filename) << "):\n" << log << std::endl;
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+// Attach the two stages to the program and link it, the previous stages (if any) are replaced
+bool link_program(GLuint program, shader_source const& vertex, shader_source const& fragment)
+{
+    GLuint const vs = compile_shader(GL_VERTEX_SHADER, vertex);
+    GLuint const fs = compile_shader(GL_FRAGMENT_SHADER, fragment);
+    if (vs == 0 || fs == 0) {
+        glDeleteShader(vs);
+        glDeleteShader(fs);
+        return false;
+    }
+
+    GLuint attached[8];
+    GLsizei count = 0;
+    glGetAttachedShaders(program, 8, &count, attached);
+    for (GLsizei k = 0; k < count; ++k)
+        glDetachShader(program, attached[k]);
+
+    glAttachShader(program, vs);
+    glAttachShader(program, fs);
+    glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glLinkProgram(program);
+    glDetachShader(program, vs);
+    glDetachShader(program, fs);
+    glDeleteShader(vs);
+    glDeleteShader(fs);
+
+    GLint status = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (status != GL_TRUE) {
+        char log[2048];
+        glGetProgramInfoLog(program, sizeof(log), nullptr, log);
+        std::cerr << "Shader link failed:\n" << log << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool load_binary(GLuint program, std::string const& filename)
+{
+    mapped_file file;
+    if (!file.open(filename) || file.size <= sizeof(GLenum))
+        return false;
+    GLenum format;
+    std::memcpy(&format, file.data, sizeof(GLenum));
+    glProgramBinary(program, format, file.data + sizeof(GLenum), GLsizei(file.size - sizeof(GLenum)));
+
+    // the driver may reject a binary produced by another version
+    GLint status = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    return status == GL_TRUE;
+}
+
+void store_binary(GLuint program, std::string const& filename)
+{
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (formats == 0 || length == 0)
+        return;
+
+    std::vector<char> binary(static_cast<size_t>(length));
+    GLenum format = 0;
+    glGetProgramBinary(program, length, nullptr, &format, binary.data());
+
+    make_directory("cache");
+    make_directory(cache_directory);
+    std::ofstream stream(filename, std::ios::binary);
+    stream.write(reinterpret_cast<char const*>(&format), sizeof(format));
+    stream.write(binary.data(), length);
+}
+
+}
+
+
+shader_source shader_file(std::string const& filename)
+{
+    return { filename, read_text_file(filename) };
+}
+
+shader_source shader_preset(std::string const& name)
+{
+    return { "", opengl_shader_preset(name) };
+}
+
+GLuint shader_cache_program(shader_source const& vertex, shader_source const& fragment)
+{
+    GLuint const program = glCreateProgram();
+    std::string const filename = cache_filename(vertex, fragment);
+
+    if (!load_binary(program, filename)) {
+        if (!link_program(program, vertex, fragment))
+            error_vcl("Cannot build shader program");
+        store_binary(program, filename);
+    }
+
+    if (!vertex.filename.empty() || !fragment.filename.empty())
+        watched.push_back({ program, vertex, fragment, file_modification_time(vertex.filename), file_modification_time(fragment.filename) });
+
+    return program;
+}
+
+void shader_cache_hot_reload()
+{
+    for (watched_program& w : watched)
+    {
+        long long const vertex_time = file_modification_time(w.vertex.filename);
+        long long const fragment_time = file_modification_time(w.fragment.filename);
+        if (vertex_time == w.vertex_time && fragment_time == w.fragment_time)
+            continue;
+        w.vertex_time = vertex_time;
+        w.fragment_time = fragment_time;
+
+        shader_source vertex = w.vertex, fragment = w.fragment;
+        if (!vertex.filename.empty()) vertex.text = read_text_file(vertex.filename);
+        if (!fragment.filename.empty()) fragment.text = read_text_file(fragment.filename);
+
+        // relink in place so that every drawable using this program sees the new version
+        if (link_program(w.program, vertex, fragment)) {
+            std::cout << "Reloaded shader " << vertex.filename << " " << fragment.filename << std::endl;
+            w.vertex = vertex;
+            w.fragment = fragment;
+            store_binary(w.program, cache_filename(vertex, fragment));
+        }
+        else
+            link_program(w.program, w.vertex, w.fragment);  // keep the last working version
+    }
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "vcl/vcl.hpp"
+
+// Cache of linked shader programs
+//  - the binary of each program (glGetProgramBinary) is stored in cache/shaders/, keyed by a hash of
+//    the sources and of the driver (vendor, renderer, version)
+//  - on a miss, or if the driver rejects the binary, the program is compiled from its sources
+//  - programs built from .glsl files are watched: shader_cache_hot_reload() relinks them in place
+//    (same identifier) when a file changes
+
+struct shader_source
+{
+    std::string filename;   // empty for a vcl preset
+    std::string text;
+};
+
+shader_source shader_file(std::string const& filename);
+shader_source shader_preset(std::string const& name);
+
+GLuint shader_cache_program(shader_source const& vertex, shader_source const& fragment);
+
+// Check the watched .glsl files and rebuild the programs that changed (GL thread)
+void shader_cache_hot_reload();
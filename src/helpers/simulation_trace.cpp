@@ -0,0 +1,131 @@
+#include "simulation_trace.hpp"
+#include "mapped_file.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+
+namespace {
+
+uint32_t const trace_version = 1;
+
+struct trace_file_header
+{
+    char magic[4];      // "NTRC"
+    uint32_t version;
+    uint64_t seed;
+    float tick_dt;
+    int32_t substeps;
+    float ticks_per_second;
+    uint32_t channels;
+    uint64_t ticks;
+};
+
+}
+
+
+size_t simulation_trace::floats_per_tick() const
+{
+    size_t n = 0;
+    for (trace_channel const& channel : channels)
+        n += channel.floats;
+    return n;
+}
+
+size_t simulation_trace::ticks() const
+{
+    size_t const n = floats_per_tick();
+    return n == 0 ? 0 : states.size() / n;
+}
+
+void add_trace_channel(simulation_trace& trace, char const* name, size_t floats)
+{
+    trace_channel channel = {};
+    std::strncpy(channel.name, name, sizeof(channel.name) - 1);
+    channel.floats = uint32_t(floats);
+    trace.channels.push_back(channel);
+}
+
+bool save_trace(std::string const& filename, simulation_trace const& trace)
+{
+    trace_file_header header;
+    std::memcpy(header.magic, "NTRC", 4);
+    header.version = trace_version;
+    header.seed = trace.seed;
+    header.tick_dt = trace.tick_dt;
+    header.substeps = trace.substeps;
+    header.ticks_per_second = trace.ticks_per_second;
+    header.channels = uint32_t(trace.channels.size());
+    header.ticks = trace.ticks();
+
+    std::ofstream stream(filename, std::ios::binary);
+    if (!stream)
+        return false;
+    stream.write(reinterpret_cast<char const*>(&header), sizeof(header));
+    stream.write(reinterpret_cast<char const*>(trace.channels.data()), std::streamsize(trace.channels.size() * sizeof(trace_channel)));
+    stream.write(reinterpret_cast<char const*>(trace.states.data()), std::streamsize(header.ticks * trace.floats_per_tick() * sizeof(float)));
+    return bool(stream);
+}
+
+bool load_trace(std::string const& filename, simulation_trace& trace)
+{
+    mapped_file file;
+    if (!file.open(filename) || file.size < sizeof(trace_file_header))
+        return false;
+
+    trace_file_header header;
+    std::memcpy(&header, file.data, sizeof(header));
+    if (std::memcmp(header.magic, "NTRC", 4) != 0 || header.version != trace_version
+        || file.size < sizeof(header) + size_t(header.channels) * sizeof(trace_channel))
+        return false;
+
+    trace.seed = header.seed;
+    trace.tick_dt = header.tick_dt;
+    trace.substeps = header.substeps;
+    trace.ticks_per_second = header.ticks_per_second;
+    trace.channels.resize(header.channels);
+    std::memcpy(trace.channels.data(), file.data + sizeof(header), header.channels * sizeof(trace_channel));
+    for (trace_channel& channel : trace.channels)
+        channel.name[sizeof(channel.name) - 1] = '\0';
+
+    size_t const floats = size_t(header.ticks) * trace.floats_per_tick();
+    size_t const offset = sizeof(header) + header.channels * sizeof(trace_channel);
+    if (file.size != offset + floats * sizeof(float))
+        return false;
+    trace.states.resize(floats);
+    std::memcpy(trace.states.data(), file.data + offset, floats * sizeof(float));
+    return true;
+}
+
+trace_difference diff_traces(simulation_trace const& a, simulation_trace const& b, float tolerance)
+{
+    trace_difference difference;
+    difference.max_error.assign(a.channels.size(), 0.0f);
+    difference.same_layout = a.ticks() == b.ticks() && a.channels.size() == b.channels.size();
+    for (size_t c = 0; difference.same_layout && c < a.channels.size(); c++)
+        difference.same_layout = a.channels[c].floats == b.channels[c].floats && std::strcmp(a.channels[c].name, b.channels[c].name) == 0;
+    if (!difference.same_layout)
+        return difference;
+
+    size_t const n = a.floats_per_tick();
+    for (size_t tick = 0; tick < a.ticks(); tick++) {
+        float const* pa = a.states.data() + tick * n;
+        float const* pb = b.states.data() + tick * n;
+        for (size_t c = 0; c < a.channels.size(); c++) {
+            float error = 0.0f;
+            for (uint32_t k = 0; k < a.channels[c].floats; k++) {
+                bool const nan_a = pa[k] != pa[k], nan_b = pb[k] != pb[k];
+                // NaN on one side only is a difference as well
+                float const e = (nan_a || nan_b) ? (nan_a == nan_b ? 0.0f : INFINITY) : std::abs(pa[k] - pb[k]);
+                error = std::max(error, e);
+            }
+            difference.max_error[c] = std::max(difference.max_error[c], error);
+            if (error > tolerance && difference.first_tick < 0)
+                difference.first_tick = long(tick);
+            pa += a.channels[c].floats;
+            pb += a.channels[c].floats;
+        }
+    }
+    return difference;
+}
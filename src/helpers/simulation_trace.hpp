@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Binary trace of a simulation run: the state of every tick as a fixed number of floats
+//  - the state is cut in named channels (e.g. birds, boats, rope), compared separately by diff_traces()
+//  - the header keeps what is needed to run the same simulation again (seed, ticks, time step)
+//    and the throughput measured while recording, to compare the speed of a replay with it
+//  - file: header, channel table, then ticks x floats_per_tick() raw little-endian floats
+
+struct trace_channel
+{
+    char name[16];
+    uint32_t floats;    // per tick
+};
+
+struct simulation_trace
+{
+    uint64_t seed = 0;
+    float tick_dt = 0.0f;           // simulated time between two ticks
+    int32_t substeps = 0;
+    float ticks_per_second = 0.0f;  // throughput of the run that recorded the trace
+
+    std::vector<trace_channel> channels;
+    std::vector<float> states;      // tick after tick
+
+    size_t floats_per_tick() const;
+    size_t ticks() const;
+};
+
+void add_trace_channel(simulation_trace& trace, char const* name, size_t floats);
+
+bool save_trace(std::string const& filename, simulation_trace const& trace);
+bool load_trace(std::string const& filename, simulation_trace& trace);
+
+// Comparison tick by tick, channel by channel
+struct trace_difference
+{
+    bool same_layout = true;        // same channels and number of ticks
+    long first_tick = -1;           // first tick with an error larger than the tolerance (-1: none)
+    std::vector<float> max_error;   // largest absolute difference of each channel over the whole run
+};
+
+trace_difference diff_traces(simulation_trace const& a, simulation_trace const& b, float tolerance);
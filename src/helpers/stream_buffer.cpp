@@ -0,0 +1,121 @@
+#include "stream_buffer.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+using namespace vcl;
+
+
+namespace {
+
+// start of the sub-allocations: enough for any vertex attribute
+size_t const stream_alignment = 16;
+
+size_t aligned(size_t offset)
+{
+    return (offset + stream_alignment - 1) / stream_alignment * stream_alignment;
+}
+
+void allocate_stream_buffer(stream_buffer& stream, size_t region_size)
+{
+    // the fences protect the previous storage, which the driver keeps as long as the GPU uses it
+    for (GLsync& fence : stream.fences) {
+        if (fence != nullptr)
+            glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    stream.region_size = region_size;
+    glBindBuffer(GL_ARRAY_BUFFER, stream.vbo);
+    glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(region_size * stream.frames), nullptr, GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    stream.current = 0;
+    stream.offset = 0;
+}
+
+void stream_attribute(stream_buffer& stream, GLuint vao, GLuint location, GLint components, void const* values, size_t bytes)
+{
+    size_t const offset = stream_write(stream, values, bytes);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, stream.vbo);
+    glVertexAttribPointer(location, components, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<void const*>(offset));
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+}
+
+
+void initialize_stream_buffer(stream_buffer& stream, size_t region_size, int frames)
+{
+    stream.frames = std::max(2, std::min(frames, 4));
+    glGenBuffers(1, &stream.vbo);
+    allocate_stream_buffer(stream, std::max(region_size, size_t(4096)));
+}
+
+void begin_stream_frame(stream_buffer& stream)
+{
+    stream.current = (stream.current + 1) % stream.frames;
+    stream.offset = 0;
+    stream.written_bytes = 0;
+    stream.stall_ms = 0.0f;
+
+    GLsync& fence = stream.fences[stream.current];
+    if (fence == nullptr)
+        return;
+    auto const start = std::chrono::steady_clock::now();
+    GLenum status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    while (status == GL_TIMEOUT_EXPIRED)
+        status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000); // 1 ms
+    stream.stall_ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    glDeleteSync(fence);
+    fence = nullptr;
+}
+
+void end_stream_frame(stream_buffer& stream)
+{
+    GLsync& fence = stream.fences[stream.current];
+    if (fence != nullptr)
+        glDeleteSync(fence);
+    fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void stream_reserve(stream_buffer& stream, size_t bytes, size_t writes)
+{
+    // padding before each write but the first one, which starts at the aligned offset
+    bytes += (std::max(writes, size_t(1)) - 1) * (stream_alignment - 1);
+    if (aligned(stream.offset) + bytes > stream.region_size) {
+        allocate_stream_buffer(stream, std::max(2 * stream.region_size, 2 * bytes));
+        stream.reallocations++;
+    }
+}
+
+size_t stream_write(stream_buffer& stream, void const* data, size_t bytes)
+{
+    stream_reserve(stream, bytes);
+    size_t const start = aligned(stream.offset);
+
+    // the region is not read by the GPU anymore (its fence was waited for): no synchronization needed
+    size_t const offset = stream.current * stream.region_size + start;
+    glBindBuffer(GL_ARRAY_BUFFER, stream.vbo);
+    void* dst = glMapBufferRange(GL_ARRAY_BUFFER, GLintptr(offset), GLsizeiptr(bytes), GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+    if (dst != nullptr) {
+        std::memcpy(dst, data, bytes);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    stream.offset = start + bytes;
+    stream.written_bytes += bytes;
+    return offset;
+}
+
+void stream_vertex_attribute(stream_buffer& stream, GLuint vao, GLuint location, vec3 const* values, size_t count)
+{
+    stream_attribute(stream, vao, location, 3, values, count * sizeof(vec3));
+}
+
+void stream_vertex_attribute(stream_buffer& stream, GLuint vao, GLuint location, float const* values, size_t count)
+{
+    stream_attribute(stream, vao, location, 1, values, count * sizeof(float));
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "vcl/vcl.hpp"
+
+// Vertex buffer for the data rewritten every frame (water mesh, instance transforms, lines)
+//  - the buffer is a ring of regions, one per frame in flight: a frame writes only in its own region,
+//    with unsynchronized mappings, while the GPU may still read the regions of the previous frames
+//  - a fence is inserted at the end of each frame; before reusing a region its fence is waited for,
+//    which only blocks when the CPU is more than `frames` frames ahead of the GPU (stall time is measured)
+//  - when a frame needs more than a region, the whole buffer is orphaned and the regions are enlarged:
+//    the data written earlier in the same frame must already have been drawn (write, then draw right away)
+
+struct stream_buffer
+{
+    GLuint vbo = 0;
+    int frames = 3;
+    size_t region_size = 0;     // bytes per frame
+    int current = 0;            // region of the frame being written
+    size_t offset = 0;          // in the current region
+    GLsync fences[4] = {};
+
+    // statistics of the last frame
+    size_t written_bytes = 0;
+    float stall_ms = 0.0f;      // waiting for the GPU to release the region
+    size_t reallocations = 0;   // since the creation of the buffer
+};
+
+void initialize_stream_buffer(stream_buffer& stream, size_t region_size, int frames = 3);
+
+// Start writing the region of a new frame, waiting if the GPU still reads it
+void begin_stream_frame(stream_buffer& stream);
+// Fence the region of the frame: call after the last draw reading it
+void end_stream_frame(stream_buffer& stream);
+
+// Make room in the current region for `writes` consecutive writes of `bytes` in total (alignment included):
+// when the buffer has to be enlarged, it is orphaned before these writes and none of them is lost
+void stream_reserve(stream_buffer& stream, size_t bytes, size_t writes = 1);
+
+// Copy data to the current region, return its offset in stream.vbo
+size_t stream_write(stream_buffer& stream, void const* data, size_t bytes);
+
+// Write the values and make the attribute location of the vao read them from the stream
+void stream_vertex_attribute(stream_buffer& stream, GLuint vao, GLuint location, vcl::vec3 const* values, size_t count);
+void stream_vertex_attribute(stream_buffer& stream, GLuint vao, GLuint location, float const* values, size_t count);
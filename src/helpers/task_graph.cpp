@@ -0,0 +1,118 @@
+#include "task_graph.hpp"
+#include <algorithm>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+
+
+int task_graph::add(std::string const& name, task_thread thread, std::function<void()> job, std::vector<int> const& dependencies)
+{
+    int const id = int(tasks.size());
+    task t;
+    t.name = name;
+    t.thread = thread;
+    t.job = std::move(job);
+    t.remaining = int(dependencies.size());
+    tasks.push_back(std::move(t));
+    for (int const d : dependencies)
+        tasks[d].dependents.push_back(id); // a dependency is always added before the tasks using it
+    return id;
+}
+
+bool task_graph::run(thread_pool& pool_)
+{
+    pool = &pool_;
+    start_time = std::chrono::steady_clock::now();
+    completed = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (int id = 0; id < int(tasks.size()); id++)
+            if (tasks[id].remaining == 0)
+                dispatch(id);
+    }
+
+    // the calling thread owns the OpenGL context: it executes the main tasks until everything is completed
+    while (true) {
+        int id;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            main_wakeup.wait(lock, [this]() { return !main_queue.empty() || completed == tasks.size(); });
+            if (main_queue.empty())
+                break;
+            id = main_queue.front();
+            main_queue.pop_front();
+        }
+        execute(id);
+    }
+
+    total_ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+    return std::none_of(tasks.begin(), tasks.end(), [](task const& t) { return t.status != task_done; });
+}
+
+void task_graph::report(std::ostream& out) const
+{
+    float busy_ms = 0.0f;
+    out << "Initialization tasks (start / duration in ms):" << std::endl;
+    for (task const& t : tasks) {
+        out << "  " << std::left << std::setw(20) << t.name << std::right << (t.thread == task_main ? " main  " : " worker")
+            << std::fixed << std::setprecision(1) << std::setw(9) << t.start_ms << std::setw(9) << t.duration_ms;
+        if (t.status == task_failed) out << "  FAILED";
+        if (t.status == task_skipped) out << "  skipped";
+        out << std::endl;
+        busy_ms += t.duration_ms;
+    }
+    out << "  total " << total_ms << " ms (" << busy_ms << " ms of work)" << std::defaultfloat << std::endl;
+}
+
+// called with the mutex locked
+void task_graph::dispatch(int id)
+{
+    if (tasks[id].status == task_skipped) {
+        complete(id, false);
+        return;
+    }
+    if (tasks[id].thread == task_main) {
+        main_queue.push_back(id);
+        main_wakeup.notify_one();
+    }
+    else
+        pool->submit([this, id]() { execute(id); }, tasks[id].name.c_str());
+}
+
+void task_graph::execute(int id)
+{
+    task& t = tasks[id];
+    auto const start = std::chrono::steady_clock::now();
+    bool success = true;
+    try {
+        t.job();
+    }
+    catch (std::exception const& e) {
+        std::cerr << "Error in initialization task " << t.name << ": " << e.what() << std::endl;
+        success = false;
+    }
+    auto const end = std::chrono::steady_clock::now();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    t.start_ms = std::chrono::duration<float, std::milli>(start - start_time).count();
+    t.duration_ms = std::chrono::duration<float, std::milli>(end - start).count();
+    complete(id, success);
+}
+
+// called with the mutex locked
+void task_graph::complete(int id, bool success)
+{
+    task& t = tasks[id];
+    if (t.status == task_waiting)
+        t.status = success ? task_done : task_failed;
+    completed++;
+    for (int const d : t.dependents) {
+        if (!success)
+            tasks[d].status = task_skipped;
+        if (--tasks[d].remaining == 0)
+            dispatch(d);
+    }
+    if (completed == tasks.size())
+        main_wakeup.notify_one();
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "thread_pool.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <iosfwd>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Set of named tasks with explicit dependencies, executed once
+//  - task_worker: CPU-only work (mesh generation, placements...) run on the thread pool
+//  - task_main: work touching the OpenGL context, run one at a time on the thread calling run()
+// A task starts when all its dependencies have completed. If a task throws, the tasks depending on it are skipped.
+
+enum task_thread { task_worker, task_main };
+
+struct task_graph
+{
+    // Returns the identifier of the task, used to express the dependencies of the next ones
+    int add(std::string const& name, task_thread thread, std::function<void()> job, std::vector<int> const& dependencies = {});
+
+    // Execute every task, returns false if one of them failed
+    bool run(thread_pool& pool);
+
+    // Start time, duration and thread of each task
+    void report(std::ostream& out) const;
+
+private:
+    enum task_status { task_waiting, task_done, task_failed, task_skipped };
+
+    struct task
+    {
+        std::string name;
+        task_thread thread;
+        std::function<void()> job;
+        std::vector<int> dependents;
+        int remaining = 0;
+        task_status status = task_waiting;
+        float start_ms = 0.0f;
+        float duration_ms = 0.0f;
+    };
+
+    void execute(int id);
+    void complete(int id, bool success);
+    void dispatch(int id);
+
+    std::vector<task> tasks;
+    thread_pool* pool = nullptr;
+    std::deque<int> main_queue;
+    size_t completed = 0;
+    std::mutex mutex;
+    std::condition_variable main_wakeup;
+    std::chrono::steady_clock::time_point start_time;
+    float total_ms = 0.0f;
+};
@@ -0,0 +1,254 @@
+#include "texture_bake.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <dirent.h>
+#endif
+
+using namespace vcl;
+
+
+namespace {
+
+// same face order as cubemap_texture: left, right, top, bottom, front, back
+char const* const cubemap_face_names[6] = { "left", "right", "top", "bottom", "front", "back" };
+GLenum const cubemap_face_targets[6] = { GL_TEXTURE_CUBE_MAP_NEGATIVE_X, GL_TEXTURE_CUBE_MAP_POSITIVE_X,
+                                         GL_TEXTURE_CUBE_MAP_POSITIVE_Y, GL_TEXTURE_CUBE_MAP_NEGATIVE_Y,
+                                         GL_TEXTURE_CUBE_MAP_POSITIVE_Z, GL_TEXTURE_CUBE_MAP_NEGATIVE_Z };
+
+struct rgba_image
+{
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<unsigned char> pixels;
+};
+
+rgba_image to_rgba(image_raw const& im)
+{
+    rgba_image out;
+    out.width = im.width;
+    out.height = im.height;
+    size_t const N = size_t(im.width) * im.height;
+    out.pixels.resize(4 * N);
+    if (im.color_type == image_color_type::rgba)
+        std::memcpy(out.pixels.data(), ptr(im.data), 4 * N);
+    else {
+        for (size_t k = 0; k < N; ++k) {
+            out.pixels[4 * k + 0] = im.data[3 * k + 0];
+            out.pixels[4 * k + 1] = im.data[3 * k + 1];
+            out.pixels[4 * k + 2] = im.data[3 * k + 2];
+            out.pixels[4 * k + 3] = 255;
+        }
+    }
+    return out;
+}
+
+// Next mip level: average of 2x2 pixels (the last row/column is repeated for odd sizes)
+rgba_image downsample(rgba_image const& im)
+{
+    rgba_image out;
+    out.width = std::max(1u, im.width / 2);
+    out.height = std::max(1u, im.height / 2);
+    out.pixels.resize(4 * size_t(out.width) * out.height);
+    for (uint32_t y = 0; y < out.height; ++y) {
+        uint32_t const y0 = std::min(2 * y, im.height - 1), y1 = std::min(2 * y + 1, im.height - 1);
+        for (uint32_t x = 0; x < out.width; ++x) {
+            uint32_t const x0 = std::min(2 * x, im.width - 1), x1 = std::min(2 * x + 1, im.width - 1);
+            for (int c = 0; c < 4; ++c) {
+                unsigned int const sum = im.pixels[4 * (size_t(y0) * im.width + x0) + c] + im.pixels[4 * (size_t(y0) * im.width + x1) + c]
+                                       + im.pixels[4 * (size_t(y1) * im.width + x0) + c] + im.pixels[4 * (size_t(y1) * im.width + x1) + c];
+                out.pixels[4 * (size_t(y) * out.width + x) + c] = static_cast<unsigned char>((sum + 2) / 4);
+            }
+        }
+    }
+    return out;
+}
+
+std::vector<rgba_image> mip_chain(image_raw const& im)
+{
+    std::vector<rgba_image> chain;
+    chain.push_back(to_rgba(im));
+    while (chain.back().width > 1 || chain.back().height > 1)
+        chain.push_back(downsample(chain.back()));
+    return chain;
+}
+
+bool write_container(std::string const& output, std::vector<std::vector<rgba_image>> const& faces)
+{
+    baked_texture_header header;
+    std::memcpy(header.magic, "NTEX", 4);
+    header.version = 1;
+    header.faces = uint32_t(faces.size());
+    header.levels = uint32_t(faces[0].size());
+    header.width = faces[0][0].width;
+    header.height = faces[0][0].height;
+
+    // pixels start after the level table, aligned on 16 bytes
+    std::vector<baked_texture_level> table;
+    uint64_t offset = sizeof(header) + faces.size() * faces[0].size() * sizeof(baked_texture_level);
+    offset = (offset + 15) & ~uint64_t(15);
+    for (auto const& face : faces) {
+        for (rgba_image const& level : face) {
+            table.push_back({ offset, level.width, level.height });
+            offset += level.pixels.size();
+        }
+    }
+
+    std::ofstream stream(output, std::ios::binary);
+    if (!stream)
+        return false;
+    stream.write(reinterpret_cast<char const*>(&header), sizeof(header));
+    stream.write(reinterpret_cast<char const*>(table.data()), std::streamsize(table.size() * sizeof(baked_texture_level)));
+    while (uint64_t(stream.tellp()) < table[0].offset)
+        stream.put(0);
+    for (auto const& face : faces)
+        for (rgba_image const& level : face)
+            stream.write(reinterpret_cast<char const*>(level.pixels.data()), std::streamsize(level.pixels.size()));
+    return bool(stream);
+}
+
+std::string directory_name(std::string path)
+{
+    while (!path.empty() && (path.back() == '/' || path.back() == '\\'))
+        path.pop_back();
+    size_t const slash = path.find_last_of("/\\");
+    return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+std::string parent_directory(std::string path)
+{
+    while (!path.empty() && (path.back() == '/' || path.back() == '\\'))
+        path.pop_back();
+    size_t const slash = path.find_last_of("/\\");
+    return slash == std::string::npos ? "" : path.substr(0, slash + 1);
+}
+
+std::vector<std::string> list_directory(std::string const& directory_path)
+{
+    std::vector<std::string> names;
+#ifdef _WIN32
+    WIN32_FIND_DATAA entry;
+    HANDLE const handle = FindFirstFileA((directory_path + "*").c_str(), &entry);
+    if (handle == INVALID_HANDLE_VALUE)
+        return names;
+    do names.push_back(entry.cFileName); while (FindNextFileA(handle, &entry));
+    FindClose(handle);
+#else
+    DIR* const directory = opendir(directory_path.c_str());
+    if (directory == nullptr)
+        return names;
+    while (dirent const* entry = readdir(directory))
+        names.push_back(entry->d_name);
+    closedir(directory);
+#endif
+    return names;
+}
+
+bool ends_with(std::string const& s, std::string const& suffix)
+{
+    return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+}
+
+
+std::string baked_texture_path(std::string const& source)
+{
+    std::string const name = directory_name(source);
+    std::string const stem = ends_with(name, ".png") ? name.substr(0, name.size() - 4) : name;
+    return parent_directory(source) + "baked/" + stem + ".ntex";
+}
+
+bool baked_texture_is_fresh(std::string const& source)
+{
+    long long const baked_time = file_modification_time(baked_texture_path(source));
+    if (baked_time == 0)
+        return false;
+    if (ends_with(source, ".png"))
+        return baked_time >= file_modification_time(source);
+    for (char const* face : cubemap_face_names)
+        if (baked_time < file_modification_time(source + face + ".png"))
+            return false;
+    return true;
+}
+
+bool bake_texture(std::string const& filename, std::string const& output)
+{
+    std::vector<std::vector<rgba_image>> faces;
+    faces.push_back(mip_chain(image_load_png(filename)));
+    return write_container(output, faces);
+}
+
+bool bake_cubemap(std::string const& directory_path, std::string const& output)
+{
+    std::vector<std::vector<rgba_image>> faces;
+    for (char const* face : cubemap_face_names)
+        faces.push_back(mip_chain(image_load_png(directory_path + face + ".png")));
+    for (auto const& face : faces) {
+        if (face[0].width != faces[0][0].width || face[0].height != faces[0][0].height) {
+            std::cerr << "Cubemap faces of " << directory_path << " do not have the same size" << std::endl;
+            return false;
+        }
+    }
+    return write_container(output, faces);
+}
+
+void bake_pictures(std::string const& directory_path)
+{
+    make_directory(directory_path + "baked");
+    for (std::string const& name : list_directory(directory_path)) {
+        if (name == "." || name == ".." || name == "baked")
+            continue;
+        std::string const path = directory_path + name;
+        bool ok = true;
+        if (ends_with(name, ".png"))
+            ok = bake_texture(path, baked_texture_path(path));
+        else if (file_modification_time(path + "/left.png") != 0)
+            ok = bake_cubemap(path + "/", baked_texture_path(path + "/"));
+        else
+            continue;
+        std::cout << (ok ? "Baked " : "Failed to bake ") << path << std::endl;
+    }
+}
+
+bool open_baked_texture(std::string const& filename, GLenum target, baked_texture& texture)
+{
+    if (!texture.file.open(filename) || texture.file.size < sizeof(baked_texture_header))
+        return false;
+    texture.header = reinterpret_cast<baked_texture_header const*>(texture.file.data);
+    texture.levels = reinterpret_cast<baked_texture_level const*>(texture.file.data + sizeof(baked_texture_header));
+
+    baked_texture_header const& header = *texture.header;
+    uint32_t const faces = target == GL_TEXTURE_CUBE_MAP ? 6 : 1;
+    size_t const N = size_t(header.faces) * header.levels;
+    if (std::memcmp(header.magic, "NTEX", 4) != 0 || header.version != 1 || header.faces != faces || header.levels == 0
+            || sizeof(baked_texture_header) + N * sizeof(baked_texture_level) > texture.file.size)
+        return false;
+    for (size_t k = 0; k < N; ++k) {
+        baked_texture_level const& level = texture.levels[k];
+        if (level.offset + 4 * uint64_t(level.width) * level.height > texture.file.size)
+            return false;
+    }
+    return true;
+}
+
+void upload_baked_texture(baked_texture const& texture, GLenum target)
+{
+    baked_texture_header const& header = *texture.header;
+    for (uint32_t face = 0; face < header.faces; ++face) {
+        GLenum const face_target = target == GL_TEXTURE_CUBE_MAP ? cubemap_face_targets[face] : target;
+        for (uint32_t level = 0; level < header.levels; ++level) {
+            baked_texture_level const& l = texture.levels[face * header.levels + level];
+            glTexImage2D(face_target, GLint(level), GL_RGBA8, GLsizei(l.width), GLsizei(l.height), 0, GL_RGBA, GL_UNSIGNED_BYTE, texture.file.data + l.offset);
+        }
+    }
+    glTexParameteri(target, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, GLint(header.levels) - 1);
+    glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+}
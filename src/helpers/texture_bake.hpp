@@ -0,0 +1,53 @@
+#pragma once
+
+#include "vcl/vcl.hpp"
+#include "mapped_file.hpp"
+#include <cstdint>
+
+// Baked texture container (.ntex) produced offline from the PNG files (option --bake)
+//  - RGBA8 pixels of the full mip chain, ready to be sent to the GPU without decoding
+//  - a cubemap stores its six faces (left, right, top, bottom, front, back)
+//  - layout: header | level table (face major) | pixels
+
+struct baked_texture_header
+{
+    char magic[4];      // "NTEX"
+    uint32_t version;
+    uint32_t faces;     // 1: 2D texture, 6: cubemap
+    uint32_t levels;
+    uint32_t width;
+    uint32_t height;
+};
+
+struct baked_texture_level
+{
+    uint64_t offset;    // from the beginning of the file
+    uint32_t width;
+    uint32_t height;
+};
+
+// pictures/name.png -> pictures/baked/name.ntex and pictures/skybox_sky/ -> pictures/baked/skybox_sky.ntex
+std::string baked_texture_path(std::string const& source);
+
+// True if the baked file exists and is more recent than its source image(s)
+bool baked_texture_is_fresh(std::string const& source);
+
+bool bake_texture(std::string const& filename, std::string const& output);
+bool bake_cubemap(std::string const& directory_path, std::string const& output);
+
+// Bake every PNG of the directory, and every sub-directory containing a cubemap
+void bake_pictures(std::string const& directory_path);
+
+// Mapped container: the pixels are read directly from the mapping
+struct baked_texture
+{
+    mapped_file file;
+    baked_texture_header const* header = nullptr;
+    baked_texture_level const* levels = nullptr;
+};
+
+// False if the file is not a valid container for target (6 faces for GL_TEXTURE_CUBE_MAP, 1 otherwise)
+bool open_baked_texture(std::string const& filename, GLenum target, baked_texture& texture);
+
+// Send every level of every face to the texture currently bound on target (GL_TEXTURE_2D or GL_TEXTURE_CUBE_MAP)
+void upload_baked_texture(baked_texture const& texture, GLenum target);
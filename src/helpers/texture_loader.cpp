@@ -0,0 +1,235 @@
+#include "texture_loader.hpp"
+#include "thread_pool.hpp"
+#include "texture_bake.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <mutex>
+
+using namespace vcl;
+
+
+namespace {
+
+struct texture_request
+{
+    GLuint id = 0;
+    GLenum target = GL_TEXTURE_2D;
+    GLint wrap_s = GL_MIRRORED_REPEAT;
+    GLint wrap_t = GL_MIRRORED_REPEAT;
+    GLint internal_format = 0;   // 0: deduced from the image
+    std::vector<std::string> filenames;
+    std::vector<image_raw> images;
+    std::string baked_filename;                 // empty when decoding the PNG files
+    std::unique_ptr<baked_texture> baked;
+    std::atomic<int> remaining_decodes{0};
+};
+
+std::mutex ready_mutex;
+std::vector<std::shared_ptr<texture_request>> ready;   // decoded, waiting for upload
+std::atomic<size_t> in_flight{0};                       // requested but not uploaded yet
+bool upload_with_pbo = false;
+GLuint pbo = 0;
+size_t pbo_size = 0;
+
+// Same order as in cubemap_texture: left, right, top, bottom, front, back
+GLenum const cubemap_faces[6] = { GL_TEXTURE_CUBE_MAP_NEGATIVE_X, GL_TEXTURE_CUBE_MAP_POSITIVE_X,
+                                  GL_TEXTURE_CUBE_MAP_POSITIVE_Y, GL_TEXTURE_CUBE_MAP_NEGATIVE_Y,
+                                  GL_TEXTURE_CUBE_MAP_POSITIVE_Z, GL_TEXTURE_CUBE_MAP_NEGATIVE_Z };
+
+void push_ready(std::shared_ptr<texture_request> const& request)
+{
+    std::lock_guard<std::mutex> lock(ready_mutex);
+    ready.push_back(request);
+}
+
+void submit_decodes(std::shared_ptr<texture_request> const& request)
+{
+    if (!request->baked_filename.empty()) {
+        ++in_flight;
+        default_thread_pool().submit([request]() {
+            request->baked.reset(new baked_texture);
+            if (!open_baked_texture(request->baked_filename, request->target, *request->baked)) {
+                // decode the PNG files instead (submitted before this request leaves the in-flight count)
+                std::cerr << "Invalid baked texture " << request->baked_filename << ", decoding the source images" << std::endl;
+                request->baked.reset();
+                request->baked_filename.clear();
+                submit_decodes(request);
+                --in_flight;
+                return;
+            }
+            // touch every page on the worker so that the upload does not wait for the disk
+            volatile unsigned char sum = 0;
+            for (size_t k = 0; k < request->baked->file.size; k += 4096)
+                sum += request->baked->file.data[k];
+            push_ready(request);
+        });
+        return;
+    }
+
+    size_t const N = request->filenames.size();
+    request->images.resize(N);
+    request->remaining_decodes = int(N);
+    ++in_flight;
+
+    for (size_t k = 0; k < N; ++k) {
+        default_thread_pool().submit([request, k]() {
+            // a missing file leaves an empty image: the placeholder is kept
+            try {
+                request->images[k] = image_load_png(request->filenames[k]);
+            }
+            catch (std::exception const& e) {
+                std::cerr << "Cannot load texture " << request->filenames[k] << ": " << e.what() << std::endl;
+            }
+            // the last decoded image makes the texture ready for upload
+            if (--request->remaining_decodes == 0)
+                push_ready(request);
+        });
+    }
+}
+
+void upload_image(GLenum target, image_raw const& im, GLint internal_format)
+{
+    GLenum const format = im.color_type == image_color_type::rgba ? GL_RGBA : GL_RGB;
+    if (internal_format == 0)
+        internal_format = im.color_type == image_color_type::rgba ? GL_RGBA8 : GL_RGB8;
+    size_t const size = im.data.size();
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    if (upload_with_pbo) {
+        if (pbo == 0)
+            glGenBuffers(1, &pbo);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+        if (size > pbo_size) {
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, GLsizeiptr(size), nullptr, GL_STREAM_DRAW);
+            pbo_size = size;
+        }
+        void* dst = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, GLsizeiptr(size), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        std::memcpy(dst, ptr(im.data), size);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        glTexImage2D(target, 0, internal_format, GLsizei(im.width), GLsizei(im.height), 0, format, GL_UNSIGNED_BYTE, nullptr);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+    else
+        glTexImage2D(target, 0, internal_format, GLsizei(im.width), GLsizei(im.height), 0, format, GL_UNSIGNED_BYTE, ptr(im.data));
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+void upload(texture_request& request)
+{
+    --in_flight;
+    if (!request.baked_filename.empty()) {
+        glBindTexture(request.target, request.id);
+        upload_baked_texture(*request.baked, request.target);
+        glBindTexture(request.target, 0);
+        request.baked.reset();  // unmap the file
+        return;
+    }
+
+    for (image_raw const& im : request.images)
+        if (im.data.size() == 0)
+            return;
+
+    glBindTexture(request.target, request.id);
+    if (request.target == GL_TEXTURE_CUBE_MAP) {
+        for (int k = 0; k < 6; ++k)
+            upload_image(cubemap_faces[k], request.images[k], request.internal_format);
+    }
+    else {
+        upload_image(GL_TEXTURE_2D, request.images[0], request.internal_format);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    }
+    glBindTexture(request.target, 0);
+
+    // the decoded pixels are not needed anymore on the CPU
+    request.images.clear();
+}
+
+// 1x1 white texture displayed until the real image arrives
+GLuint create_placeholder(GLenum target, GLint wrap_s, GLint wrap_t)
+{
+    unsigned char const white[4] = { 255, 255, 255, 255 };
+    GLuint id;
+    glGenTextures(1, &id);
+    glBindTexture(target, id);
+    if (target == GL_TEXTURE_CUBE_MAP) {
+        for (int k = 0; k < 6; ++k)
+            glTexImage2D(cubemap_faces[k], 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, white);
+        glTexParameteri(target, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+        glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    }
+    else {
+        glTexImage2D(target, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, white);
+        glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    }
+    glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(target, GL_TEXTURE_WRAP_S, wrap_s);
+    glTexParameteri(target, GL_TEXTURE_WRAP_T, wrap_t);
+    glBindTexture(target, 0);
+    return id;
+}
+
+}
+
+
+GLuint texture_load_async(std::string const& filename, GLint wrap_s, GLint wrap_t)
+{
+    auto request = std::make_shared<texture_request>();
+    request->id = create_placeholder(GL_TEXTURE_2D, wrap_s, wrap_t);
+    request->wrap_s = wrap_s;
+    request->wrap_t = wrap_t;
+    request->filenames = { filename };
+    if (baked_texture_is_fresh(filename))
+        request->baked_filename = baked_texture_path(filename);
+    submit_decodes(request);
+    return request->id;
+}
+
+GLuint cubemap_texture_load_async(std::string const& directory_path)
+{
+    auto request = std::make_shared<texture_request>();
+    request->target = GL_TEXTURE_CUBE_MAP;
+    request->id = create_placeholder(GL_TEXTURE_CUBE_MAP, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+    request->internal_format = GL_RGBA4;   // same storage as cubemap_texture()
+    for (char const* face : { "left", "right", "top", "bottom", "front", "back" })
+        request->filenames.push_back(directory_path + face + ".png");
+    if (baked_texture_is_fresh(directory_path))
+        request->baked_filename = baked_texture_path(directory_path);   // RGBA8 with mip levels
+    submit_decodes(request);
+    return request->id;
+}
+
+size_t texture_loader_upload_pending(size_t max_uploads)
+{
+    std::vector<std::shared_ptr<texture_request>> batch;
+    {
+        std::lock_guard<std::mutex> lock(ready_mutex);
+        size_t const N = std::min(max_uploads, ready.size());
+        batch.assign(ready.begin(), ready.begin() + N);
+        ready.erase(ready.begin(), ready.begin() + N);
+    }
+    for (auto& request : batch)
+        upload(*request);
+    return batch.size();
+}
+
+void texture_loader_finish()
+{
+    default_thread_pool().wait_idle();
+    texture_loader_upload_pending(size_t(-1));
+}
+
+size_t texture_loader_remaining()
+{
+    return in_flight;
+}
+
+void texture_loader_use_pbo(bool use_pbo)
+{
+    upload_with_pbo = use_pbo;
+}
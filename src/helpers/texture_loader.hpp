@@ -0,0 +1,29 @@
+#pragma once
+
+#include "vcl/vcl.hpp"
+
+// Asynchronous texture loading
+//  - the texture identifier is created immediately (GL thread) and holds a 1x1 placeholder
+//  - the PNG files are decoded in parallel by the thread pool
+//  - the decoded images are uploaded by texture_loader_upload_pending() on the GL thread,
+//    in the same texture identifier: drawables do not need to be updated
+//  - when an up to date baked container exists (see texture_bake.hpp) it is mapped instead of
+//    decoding the PNG, and its mip levels are uploaded straight from the mapping
+
+GLuint texture_load_async(std::string const& filename, GLint wrap_s = GL_MIRRORED_REPEAT, GLint wrap_t = GL_MIRRORED_REPEAT);
+
+// The six faces left/right/top/bottom/front/back.png of the directory are uploaded together
+GLuint cubemap_texture_load_async(std::string const& directory_path);
+
+// Upload at most max_uploads decoded textures (call once per frame from the GL thread)
+// Returns the number of uploaded textures
+size_t texture_loader_upload_pending(size_t max_uploads = 2);
+
+// Wait for all decodes and upload everything (GL thread)
+void texture_loader_finish();
+
+// Number of textures not yet uploaded
+size_t texture_loader_remaining();
+
+// Upload through a pixel buffer object instead of client memory
+void texture_loader_use_pbo(bool use_pbo);
@@ -0,0 +1,163 @@
+#include "texture_registry.hpp"
+#include "texture_loader.hpp"
+#include "mapped_file.hpp"
+#include <functional>
+#include <iostream>
+#include <map>
+#include <vector>
+
+using namespace vcl;
+
+
+namespace {
+
+struct texture_entry
+{
+    GLuint id = 0;
+    GLenum target = GL_TEXTURE_2D;
+    int references = 0;
+};
+
+std::map<std::string, texture_entry> entries;       // normalized path + sampler -> texture
+
+// lexical normalization: "./", "a/../" and repeated separators removed, '\\' replaced by '/'
+std::string normalize_path(std::string const& path)
+{
+    bool const absolute = !path.empty() && (path[0] == '/' || path[0] == '\\');
+    std::vector<std::string> parts;
+    std::string part;
+    for (size_t k = 0; k <= path.size(); ++k) {
+        char const c = k < path.size() ? path[k] : '/';
+        if (c != '/' && c != '\\') {
+            part += c;
+            continue;
+        }
+        if (part == "..") {
+            if (!parts.empty() && parts.back() != "..")
+                parts.pop_back();
+            else if (!absolute)
+                parts.push_back(part);
+        }
+        else if (!part.empty() && part != ".")
+            parts.push_back(part);
+        part.clear();
+    }
+
+    std::string normalized = absolute ? "/" : "";
+    for (size_t k = 0; k < parts.size(); ++k)
+        normalized += (k > 0 ? "/" : "") + parts[k];
+    // keep the trailing separator of the directories (cubemaps)
+    if (!path.empty() && (path.back() == '/' || path.back() == '\\') && !parts.empty())
+        normalized += "/";
+    return normalized;
+}
+
+std::string request_name(std::string const& path, GLint wrap_s, GLint wrap_t)
+{
+    return normalize_path(path) + "|" + std::to_string(wrap_s) + "|" + std::to_string(wrap_t);
+}
+
+// a missing file is reported; it keeps its own entry (the loader falls back to its default texture)
+void check_file(std::string const& filename)
+{
+    if (file_modification_time(filename) == 0)
+        std::cerr << "Texture file not found: " << filename << std::endl;
+}
+
+GLuint acquire(std::string const& name, GLenum target, std::function<GLuint()> const& load)
+{
+    texture_entry& entry = entries[name];
+    if (entry.references == 0) {
+        entry.id = load();
+        entry.target = target;
+    }
+    ++entry.references;
+    return entry.id;
+}
+
+size_t bytes_per_pixel(GLint internal_format)
+{
+    switch (internal_format) {
+    case GL_RGBA4: return 2;
+    case GL_RGB8: return 3;
+    default: return 4;
+    }
+}
+
+size_t texture_bytes(GLenum target, GLuint id)
+{
+    GLenum const level_target = target == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X : GL_TEXTURE_2D;
+    size_t const faces = target == GL_TEXTURE_CUBE_MAP ? 6 : 1;
+    size_t bytes = 0;
+    glBindTexture(target, id);
+    for (GLint level = 0; level < 16; ++level) {
+        GLint width = 0, height = 0, format = 0;
+        glGetTexLevelParameteriv(level_target, level, GL_TEXTURE_WIDTH, &width);
+        glGetTexLevelParameteriv(level_target, level, GL_TEXTURE_HEIGHT, &height);
+        glGetTexLevelParameteriv(level_target, level, GL_TEXTURE_INTERNAL_FORMAT, &format);
+        if (width == 0 || height == 0)
+            break;
+        bytes += faces * size_t(width) * size_t(height) * bytes_per_pixel(format);
+    }
+    glBindTexture(target, 0);
+    return bytes;
+}
+
+}
+
+
+GLuint texture_acquire(std::string const& filename, GLint wrap_s, GLint wrap_t)
+{
+    // the sampler parameters are part of the key: the same image with another wrapping is another texture
+    return acquire(request_name(filename, wrap_s, wrap_t), GL_TEXTURE_2D, [&]() {
+        check_file(filename);
+        return texture_load_async(filename, wrap_s, wrap_t);
+    });
+}
+
+GLuint cubemap_acquire(std::string const& directory_path)
+{
+    return acquire(normalize_path(directory_path) + "|cubemap", GL_TEXTURE_CUBE_MAP, [&]() {
+        for (char const* face : { "left", "right", "top", "bottom", "front", "back" })
+            check_file(directory_path + face + ".png");
+        return cubemap_texture_load_async(directory_path);
+    });
+}
+
+void texture_release(GLuint texture)
+{
+    for (auto it = entries.begin(); it != entries.end(); ++it) {
+        if (it->second.id == texture && it->second.references > 0) {
+            if (--it->second.references == 0) {
+                glDeleteTextures(1, &it->second.id);
+                entries.erase(it);
+            }
+            return;
+        }
+    }
+}
+
+size_t texture_registry_release_all()
+{
+    // an upload still pending would bind a deleted texture
+    texture_loader_finish();
+
+    size_t references = 0;
+    for (auto& it : entries) {
+        references += size_t(it.second.references);
+        glDeleteTextures(1, &it.second.id);
+    }
+    entries.clear();
+    return references;
+}
+
+texture_registry_statistics texture_registry_report()
+{
+    texture_registry_statistics statistics;
+    for (auto const& it : entries) {
+        statistics.textures++;
+        statistics.references += it.second.references;
+        statistics.bytes += texture_bytes(it.second.target, it.second.id);
+    }
+    return statistics;
+}
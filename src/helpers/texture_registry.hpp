@@ -0,0 +1,28 @@
+#pragma once
+
+#include "vcl/vcl.hpp"
+
+// Registry of the textures shared between the drawables
+//  - a texture is identified by its normalized path and its sampler parameters, without reading the file:
+//    the same image requested twice (e.g. "pictures/a.png" and "./pictures/a.png") is decoded and uploaded once
+//  - a missing file is reported when it is first requested
+//  - each acquire increments a reference count, the GPU texture is deleted by the last release
+//  - loading goes through the asynchronous texture loader
+
+GLuint texture_acquire(std::string const& filename, GLint wrap_s = GL_MIRRORED_REPEAT, GLint wrap_t = GL_MIRRORED_REPEAT);
+GLuint cubemap_acquire(std::string const& directory_path);
+void texture_release(GLuint texture);
+
+// Release the handles still held and delete their textures, once the pending loads are done
+// (at exit, while the OpenGL context exists), return the number of handles released
+size_t texture_registry_release_all();
+
+struct texture_registry_statistics
+{
+    size_t textures = 0;        // distinct GPU textures
+    size_t references = 0;      // acquired handles
+    size_t bytes = 0;           // GPU memory of the uploaded levels
+};
+
+// GPU memory is measured from the uploaded levels (call from the GL thread)
+texture_registry_statistics texture_registry_report();
@@ -0,0 +1,328 @@
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <iostream>
+
+
+// state of a scheduled job: its successors are released when it completes
+struct job_node
+{
+    std::atomic<int> remaining{ 1 };        // unfinished dependencies, plus one until schedule() has registered them all
+    std::mutex mutex;
+    bool completed = false;
+    std::vector<job_handle> successors;
+    std::function<void()> job;
+    char const* name = "job";
+};
+
+namespace {
+
+// index of the calling thread in its pool (-1 outside of any pool)
+thread_local thread_pool const* current_pool = nullptr;
+thread_local int current_worker = -1;
+
+}
+
+
+void thread_pool::job_queue::push_back(job_item&& item)
+{
+    if (count == ring.size()) {
+        // full: move the jobs in order to a ring twice as large
+        std::vector<job_item> larger(std::max(2 * ring.size(), size_t(64)));
+        for (size_t k = 0; k < count; k++)
+            larger[k] = std::move(ring[(head + k) % ring.size()]);
+        ring.swap(larger);
+        head = 0;
+    }
+    ring[(head + count) % ring.size()] = std::move(item);
+    count++;
+}
+
+void thread_pool::job_queue::pop_back(job_item& item)
+{
+    count--;
+    job_item& slot = ring[(head + count) % ring.size()];
+    item = std::move(slot);
+    slot = job_item(); // releases what the job captured
+}
+
+void thread_pool::job_queue::pop_front(job_item& item)
+{
+    job_item& slot = ring[head];
+    item = std::move(slot);
+    slot = job_item();
+    head = (head + 1) % ring.size();
+    count--;
+}
+
+
+thread_pool::thread_pool(unsigned int nb_workers)
+{
+    for (unsigned int k = 0; k < nb_workers + 1; ++k)
+        queues.emplace_back(new job_queue());
+    for (unsigned int k = 0; k < nb_workers; ++k)
+        workers.emplace_back([this, k]() { worker_loop(int(k)); });
+}
+
+thread_pool::~thread_pool()
+{
+    wait_idle();
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        stop = true;
+    }
+    wakeup.notify_all();
+    for (std::thread& worker : workers)
+        worker.join();
+}
+
+void thread_pool::push(job_item item)
+{
+    // a worker keeps its own jobs, the other threads use the shared queue
+    bool const own = current_pool == this && current_worker >= 0;
+    job_queue& queue = *queues[own ? size_t(current_worker) : workers.size()];
+    unfinished++;
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.push_back(std::move(item));
+    }
+    pending++;
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex); // no worker can miss the notification between its check and its wait
+    }
+    wakeup.notify_one();
+}
+
+bool thread_pool::pop(int worker, job_item& item)
+{
+    size_t const nb_queues = queues.size();
+
+    // own deque first (most recent job), then the shared queue (oldest job)
+    if (worker >= 0) {
+        job_queue& queue = *queues[size_t(worker)];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.count > 0) {
+            queue.pop_back(item);
+            pending--;
+            return true;
+        }
+    }
+    {
+        job_queue& queue = *queues[nb_queues - 1];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.count > 0) {
+            queue.pop_front(item);
+            pending--;
+            return true;
+        }
+    }
+
+    // steal the oldest job of another worker, starting after our own index so that thieves spread out
+    size_t const nb_workers = nb_queues - 1;
+    for (size_t k = 1; k <= nb_workers; k++) {
+        size_t const victim = (size_t(worker + 1) + k) % nb_workers;
+        if (int(victim) == worker)
+            continue;
+        job_queue& queue = *queues[victim];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.count > 0) {
+            queue.pop_front(item);
+            pending--;
+            stolen++;
+            return true;
+        }
+    }
+    return false;
+}
+
+void thread_pool::execute(job_item& item, int worker)
+{
+    if (profiler.begin)
+        profiler.begin(item.name, worker, profiler.user);
+
+    // a failing job must not stop the worker nor leave the waiting threads blocked
+    try {
+        item.job();
+    }
+    catch (std::exception const& e) {
+        std::cerr << "Error in job " << item.name << ": " << e.what() << std::endl;
+    }
+
+    if (profiler.end)
+        profiler.end(item.name, worker, profiler.user);
+
+    if (item.node) {
+        std::vector<job_handle> successors;
+        {
+            std::lock_guard<std::mutex> lock(item.node->mutex);
+            item.node->completed = true;
+            successors.swap(item.node->successors);
+        }
+        for (job_handle const& next : successors)
+            if (--next->remaining == 0)
+                push({ std::move(next->job), next->name, next });
+    }
+
+    executed++;
+    unfinished--;
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+    }
+    progress.notify_all();
+}
+
+void thread_pool::worker_loop(int worker)
+{
+    current_pool = this;
+    current_worker = worker;
+    while (true)
+    {
+        job_item item;
+        if (pop(worker, item)) {
+            execute(item, worker);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleep_mutex);
+        wakeup.wait(lock, [this]() { return stop || pending > 0; });
+        if (stop && pending == 0)
+            return;
+    }
+}
+
+void thread_pool::submit(std::function<void()> job, char const* name)
+{
+    job_item item;
+    item.job = std::move(job);
+    item.name = name;
+    push(std::move(item));
+}
+
+job_handle thread_pool::schedule(std::function<void()> job, std::vector<job_handle> const& dependencies, char const* name)
+{
+    job_handle node = std::make_shared<job_node>();
+    node->job = std::move(job);
+    node->name = name;
+    for (job_handle const& d : dependencies) {
+        if (!d)
+            continue;
+        std::lock_guard<std::mutex> lock(d->mutex);
+        if (!d->completed) {
+            node->remaining++;
+            d->successors.push_back(node);
+        }
+    }
+    // the dependencies may all have completed already
+    if (--node->remaining == 0)
+        push({ std::move(node->job), node->name, node });
+    return node;
+}
+
+bool thread_pool::done(job_handle const& handle)
+{
+    if (!handle)
+        return true;
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    return handle->completed;
+}
+
+bool thread_pool::run_one()
+{
+    job_item item;
+    int const worker = current_pool == this ? current_worker : -1;
+    if (!pop(worker, item))
+        return false;
+    execute(item, worker);
+    return true;
+}
+
+void thread_pool::wait(job_handle const& handle)
+{
+    while (!done(handle)) {
+        if (run_one())
+            continue;
+        // nothing to help with: sleep until a job completes (the timeout covers a job pushed meanwhile)
+        std::unique_lock<std::mutex> lock(sleep_mutex);
+        progress.wait_for(lock, std::chrono::milliseconds(1));
+    }
+}
+
+void thread_pool::wait_idle()
+{
+    std::unique_lock<std::mutex> lock(sleep_mutex);
+    progress.wait(lock, [this]() { return unfinished == 0; });
+}
+
+thread_pool_statistics thread_pool::statistics() const
+{
+    thread_pool_statistics s;
+    s.executed = executed;
+    s.stolen = stolen;
+    return s;
+}
+
+thread_pool& default_thread_pool()
+{
+    unsigned int const cores = std::thread::hardware_concurrency();
+    static thread_pool pool(cores > 1 ? cores - 1 : 1);
+    return pool;
+}
+
+void parallel_for_range(thread_pool& pool, size_t count, std::function<void(size_t, size_t)> const& job, size_t grain)
+{
+    if (count == 0)
+        return;
+
+    size_t const threads = pool.size() + 1;
+    size_t const chunk = std::max(grain > 0 ? grain : count / (4 * threads), size_t(1));
+    size_t const nb_chunks = (count + chunk - 1) / chunk;
+    if (nb_chunks == 1) {
+        job(0, count);
+        return;
+    }
+
+    // the state lives on the stack of the caller: it returns only once every helper has left it
+    struct loop_state
+    {
+        std::function<void(size_t, size_t)> const* job;
+        size_t count;
+        size_t chunk;
+        size_t nb_chunks;
+        std::atomic<size_t> next{ 0 };
+        std::atomic<size_t> done{ 0 };
+        std::atomic<size_t> helpers_done{ 0 };
+
+        void work()
+        {
+            for (size_t c = next++; c < nb_chunks; c = next++) {
+                size_t const begin = c * chunk;
+                try {
+                    (*job)(begin, std::min(begin + chunk, count));
+                }
+                catch (std::exception const& e) {
+                    std::cerr << "Error in parallel loop: " << e.what() << std::endl;
+                }
+                done++;
+            }
+        }
+    };
+    loop_state state;
+    state.job = &job;
+    state.count = count;
+    state.chunk = chunk;
+    state.nb_chunks = nb_chunks;
+
+    size_t const helpers = std::min(pool.size(), nb_chunks - 1);
+    loop_state* const shared = &state;
+    for (size_t k = 0; k < helpers; k++)
+        pool.submit([shared]() { shared->work(); shared->helpers_done++; }, "parallel_for");
+    state.work();
+
+    // chunks still running on other threads, or helpers not started yet: help with the pending jobs meanwhile
+    // (a helper that has not started is in a queue, so run_one ends up executing it if no worker does)
+    while (state.done < state.nb_chunks || state.helpers_done < helpers) {
+        if (!pool.run_one())
+            std::this_thread::yield();
+    }
+}
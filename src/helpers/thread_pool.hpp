@@ -0,0 +1,120 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Job system: fixed set of worker threads with work stealing
+//  - each worker has its own deque: the jobs it submits are pushed at the back and taken back from the back (LIFO, cache-warm),
+//    idle workers steal from the front of the other deques; jobs submitted from outside the pool go to a shared FIFO queue
+//  - schedule() runs a job once its dependencies have completed, wait() runs other jobs while waiting
+//  - an optional profiler hook is called around every job with the name given when submitting it
+
+struct job_node;
+typedef std::shared_ptr<job_node> job_handle;
+
+// Called around every job, e.g. to emit zones to a profiler
+// worker is the index of the thread in the pool, -1 for a thread outside the pool helping while it waits
+struct job_profiler_hook
+{
+    void (*begin)(char const* name, int worker, void* user) = nullptr;
+    void (*end)(char const* name, int worker, void* user) = nullptr;
+    void* user = nullptr;
+};
+
+struct thread_pool_statistics
+{
+    size_t executed = 0;    // jobs run since the creation of the pool
+    size_t stolen = 0;      // jobs taken from the deque of another worker
+};
+
+struct thread_pool
+{
+    explicit thread_pool(unsigned int nb_workers);
+    ~thread_pool();
+
+    thread_pool(thread_pool const&) = delete;
+    thread_pool& operator=(thread_pool const&) = delete;
+
+    // name must outlive the job (string literal, or a string owned by the caller)
+    void submit(std::function<void()> job, char const* name = "job");
+
+    // Run job after every dependency has completed; the handle can be waited for or used as a dependency
+    job_handle schedule(std::function<void()> job, std::vector<job_handle> const& dependencies = {}, char const* name = "job");
+    static bool done(job_handle const& handle);
+
+    // Block until the job has completed, executing pending jobs meanwhile
+    void wait(job_handle const& handle);
+
+    // Execute one pending job on the calling thread, return false if there was none
+    bool run_one();
+
+    // Block until every submitted job has completed
+    void wait_idle();
+
+    size_t size() const { return workers.size(); }
+
+    void set_profiler(job_profiler_hook const& hook) { profiler = hook; }
+    thread_pool_statistics statistics() const;
+
+private:
+    struct job_item
+    {
+        std::function<void()> job;
+        char const* name = "job";
+        job_handle node;    // set for the scheduled jobs: completes the node and releases its successors
+    };
+    // ring of jobs: its storage is kept when it empties, so submitting jobs in steady state does not allocate
+    struct job_queue
+    {
+        std::mutex mutex;
+        std::vector<job_item> ring;
+        size_t head = 0;
+        size_t count = 0;
+
+        void push_back(job_item&& item);
+        void pop_back(job_item& item);
+        void pop_front(job_item& item);
+    };
+
+    void push(job_item item);
+    bool pop(int worker, job_item& item);
+    void execute(job_item& item, int worker);
+    void worker_loop(int worker);
+
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<job_queue>> queues; // one per worker, then the queue of the outside threads
+    std::atomic<size_t> pending{ 0 };               // jobs waiting in the queues
+    std::atomic<size_t> unfinished{ 0 };            // jobs submitted and not completed
+    std::atomic<size_t> executed{ 0 };
+    std::atomic<size_t> stolen{ 0 };
+    std::mutex sleep_mutex;
+    std::condition_variable wakeup;
+    std::condition_variable progress;               // a job has completed
+    bool stop = false;
+    job_profiler_hook profiler;
+};
+
+// Pool shared by the whole application (one worker per core, minus the main thread)
+thread_pool& default_thread_pool();
+
+// Call job(begin, end) on consecutive chunks covering [0,count) and return when every call has completed
+// The calling thread takes part in the work, so this can also be used from a worker thread
+// grain is the minimal size of a chunk (0: about 4 chunks per thread)
+// No heap allocation as long as the job fits in the small buffer of std::function (e.g. a lambda capturing one reference)
+void parallel_for_range(thread_pool& pool, size_t count, std::function<void(size_t, size_t)> const& job, size_t grain = 0);
+
+// Call job(i) for i in [0,count), see parallel_for_range
+// The job is passed by reference to the chunks: it can capture anything without being copied into a std::function
+template <typename F>
+void parallel_for(thread_pool& pool, size_t count, F const& job)
+{
+    parallel_for_range(pool, count, [&job](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+            job(i);
+    });
+}
@@ -0,0 +1,28 @@
+#include "wind.hpp"
+#include <algorithm>
+#include <cmath>
+
+using namespace vcl;
+
+
+std::vector<float> wind_weights(mesh const& shape, vec3 const& anchor, float exponent, bool horizontal)
+{
+    size_t const N = shape.position.size();
+    std::vector<float> weights(N);
+
+    float d_max = 0.0f;
+    for (size_t k = 0; k < N; k++) {
+        vec3 d = shape.position[k] - anchor;
+        if (horizontal)
+            d.z = 0.0f;
+        weights[k] = std::sqrt(d.x * d.x + d.y * d.y + d.z * d.z);
+        d_max = std::max(d_max, weights[k]);
+    }
+    if (d_max <= 0.0f)
+        return weights;
+
+    for (size_t k = 0; k < N; k++)
+        weights[k] = std::pow(weights[k] / d_max, exponent);
+    return weights;
+}
+
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "vcl/vcl.hpp"
+#include <vector>
+
+// Wind sway of the vegetation, computed entirely in shader/mesh_wind.vert.glsl
+//  - each vertex has a weight in [0,1] computed once with its mesh: 0 where the plant is rigid (trunk, stem), 1 at the leaf tips
+//  - the phase of each instance is derived in the shader from the translation of its model matrix
+//  - per frame only two uniforms are set (time and wind vector): no buffer is sent to the GPU
+
+// Weights growing as (d/d_max)^exponent with the distance d to the anchor (only the horizontal distance if horizontal is true)
+std::vector<float> wind_weights(vcl::mesh const& shape, vcl::vec3 const& anchor, float exponent = 2.0f, bool horizontal = false);
+
+// Send the weights once and attach them to the vao of the drawable (attribute at location 6)
+void attach_wind_weights(vcl::mesh_drawable& drawable, std::vector<float> const& weights);
+
+// Per-frame uniforms of the wind shader
+void wind_set_uniforms(GLuint shader, float time, vcl::vec2 const& wind);
@@ -0,0 +1,30 @@
+#include "wind.hpp"
+
+using namespace vcl;
+
+
+void attach_wind_weights(mesh_drawable& drawable, std::vector<float> const& weights)
+{
+    GLuint vbo = 0;
+    glGenBuffers(1, &vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(weights.size() * sizeof(float)), weights.data(), GL_STATIC_DRAW);
+
+    glBindVertexArray(drawable.vao);
+    glEnableVertexAttribArray(6);
+    glVertexAttribPointer(6, 1, GL_FLOAT, GL_FALSE, 0, nullptr);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    drawable.vbo["wind"] = vbo;
+}
+
+void wind_set_uniforms(GLuint shader, float time, vec2 const& wind)
+{
+    if (shader == 0)
+        return;
+    glUseProgram(shader);
+    glUniform1f(glGetUniformLocation(shader, "wind_time"), time);
+    glUniform2f(glGetUniformLocation(shader, "wind"), wind.x, wind.y);
+    glUseProgram(0);
+}
@@ -20,7 +20,8 @@ struct bird_parameters {
 vcl::hierarchy_mesh_drawable create_bird(float const radius_head, vcl::vec3 const scale_body, float const width_wing, float const length_wing, float const radius_beak, float const height_beak);
 vcl::hierarchy_mesh_drawable create_bird(bird_parameters &parameters, float size);
 void initialize_bird(vcl::hierarchy_mesh_drawable& bird, float size);
-void initialize_leader_bird(vcl::hierarchy_mesh_drawable& bird, float size, vcl::buffer<vcl::vec3> &key_positions, vcl::buffer<float> &key_times);
-void update_bird(vcl::hierarchy_mesh_drawable& bird, vcl::vec3 position, float t, float theta, bool change_orientation);
-void update_leader_bird(vcl::hierarchy_mesh_drawable& bird, float t, float dt, vcl::buffer<vcl::vec3>& key_positions, vcl::buffer<float>& key_times, vcl::buffer<vcl::vec3>& speeds);
-void update_follower_birds(vcl::hierarchy_mesh_drawable& leader, vcl::buffer<vcl::vec3>& followers, vcl::buffer<vcl::vec3>& speeds, float t, float dt, float k_attr, float k_rep, float k_frott);
+float initialize_leader_path(vcl::buffer<vcl::vec3> &key_positions, vcl::buffer<float> &key_times);
+float initialize_leader_bird(vcl::hierarchy_mesh_drawable& bird, float size, vcl::buffer<vcl::vec3> &key_positions, vcl::buffer<float> &key_times);
+void animate_bird_wings(vcl::hierarchy_mesh_drawable& bird, float t);
+void update_leader_bird(vcl::vec3& position, float t, float dt, vcl::buffer<vcl::vec3> const& key_positions, vcl::buffer<float> const& key_times, vcl::vec3& speed, float& heading);
+void update_follower_birds(vcl::vec3 const& leader_position, vcl::vec3 const& leader_speed, vcl::vec3* followers, vcl::vec3* speeds, size_t count, float t, float dt, float k_attr, float k_rep, float k_frott);
@@ -1,5 +1,8 @@
 #include "boat.hpp"
 #include "../helpers/interpolation.hpp"
+#include "../helpers/mesh_builder.hpp"
+#include "../helpers/mesh_cache.hpp"
+#include "../helpers/random.hpp"
 #include <cmath>
 
 using namespace vcl;
@@ -9,7 +12,31 @@ using namespace vcl;
 vcl::buffer<vcl::vec3> key_positions = { {8.0f,6.0f,0.08f}, {8.0f,6.0f,0.08f}, {7.0f,5.5f,0.08f}, {2.0f,4.0f,0.08f}, {1.0f,-1.0f,0.08f},
                                          {-2.0f,-8.0f,0.08f}, {-6.0f,-10.0f,0.08f}, {-7.9f,-10.95f,0.08f}, {-8.0f,-11.0f,0.08f}, {-8.0f,-11.0f,0.08f} };
 vcl::buffer<float> key_times = { 0.0f, 2.0f, 6.0f, 12.0f, 18.0f, 26.0f, 32.0f,  34.0f,  36.0f, 38.0f };
-int idx_last_key_time_boat;
+
+vcl::buffer<vcl::vec3> const& get_drift_key_positions()
+{
+    return key_positions;
+}
+
+vcl::buffer<float> const& get_drift_key_times()
+{
+    return key_times;
+}
+
+// tirages du mouvement brownien de la barque attachee
+rng_stream rng_boat;
+
+// position de depart de la barque attachee, autour de laquelle elle bouge
+vcl::vec3 get_moored_boat_position()
+{
+    return { 0.0f, 0.0f, 0.2f };
+}
+
+// (re)demarre les tirages : le mouvement de la barque ne depend que de la graine globale
+void initialize_boat_motion()
+{
+    rng_boat = rng_create("boat_brownian");
+}
 
 
 // creation de la forme de la barque avec des courbes non triviales
@@ -50,8 +77,6 @@ vcl::mesh create_boat(float radius, float width, float height, unsigned int N)
 	boat.connectivity.push_back({ 3 * N - 2, N - 1, N });
 	boat.connectivity.push_back({ 3 * N - 2, 2 * N - 1, N });
 
-	boat.fill_empty_field();
-
 	
 	mesh fond;
 	fond.position.resize(2 * N);
@@ -78,34 +103,20 @@ vcl::mesh create_boat(float radius, float width, float height, unsigned int N)
 	fond.connectivity.push_back({ 0, 1, N + 1 });
 	fond.connectivity.push_back({ N - 1, 2 * N - 1, N });
 
-	fond.fill_empty_field();
-
-	boat.push_back(fond);
-
-	return boat;
+	// coque et fond reunis, normales calculees une seule fois a la fin
+	mesh_builder hull;
+	hull.reserve(boat.position.size() + fond.position.size(), boat.connectivity.size() + fond.connectivity.size());
+	hull.append(boat);
+	hull.append(fond);
+	return hull.finish();
 }
 
-// initialisation du mesh_drawable : taille, texture, position de depart
-void initialize_boat(vcl::mesh_drawable& boat, float size)
+// forme de la barque a la taille voulue, conservee dans le cache de meshes (calcul CPU seulement)
+vcl::mesh create_boat_shape(float size)
 {
-	boat = vcl::mesh_drawable(create_boat(size * 7.0f, size * 2.0f, size * 1.0f, 50));
-	//boat.shading.color = { 196.0 / 255, 128.0 / 255, 77.0/255 };
-	boat.transform.translate.z = 0.2f;
-
-	// Load an image from a file
-	image_raw const im = image_load_png("pictures/texture_boat_2.png");
-
-	// Send this image to the GPU, and get its identifier texture_image_id
-	GLuint const texture_image_id = opengl_texture_to_gpu(im,
-		GL_MIRRORED_REPEAT /*GL_CLAMP_TO_EDGE*/ /**GL_TEXTURE_WRAP_S*/,
-		GL_MIRRORED_REPEAT /*GL_CLAMP_TO_EDGE*/ /**GL_TEXTURE_WRAP_T*/);
-
-	// Associate the texture_image_id to the image texture used when displaying visual
-	boat.texture = texture_image_id;
-    idx_last_key_time_boat = 1;
+	return cached_mesh("boat", { size * 7.0f, size * 2.0f, size * 1.0f, 50.0f }, 0, [size]() { return create_boat(size * 7.0f, size * 2.0f, size * 1.0f, 50); });
 }
 
-
 // on recupere la position de la proue pour y attacher la corde
 vcl::vec3 get_translation_to_bow(float size)
 {
@@ -115,53 +126,32 @@ vcl::vec3 get_translation_to_bow(float size)
 
 // update la position de la barque attachee en fonction du temps
 // animation descriptive (fonction sin(t)) couplee avec un mouvement brownien pour plus de realisme
-void update_pos_boat(vcl::mesh_drawable& boat, float t, float tmax)
+void update_pos_boat(vcl::vec3& position, float t, float tmax)
 {
-    boat.transform.translate = {4.0f+std::sin(20*pi*(t+ static_cast <float> (rand()) / (static_cast <float> (RAND_MAX / 0.01f))) /tmax)/10 + static_cast <float> (rand()) / (static_cast <float> (RAND_MAX / 0.002f)) - 0.001f,-9.0f + static_cast <float> (rand()) / (static_cast <float> (RAND_MAX / 0.002f)) - 0.001f,0.08f};
+    float const phase = rng_uniform(rng_boat, 0.0f, 0.01f);
+    float const dx = rng_uniform(rng_boat, -0.001f, 0.001f);
+    float const dy = rng_uniform(rng_boat, -0.001f, 0.001f);
+    position = {4.0f+std::sin(20*pi*(t+phase)/tmax)/10 + dx,-9.0f + dy,0.08f};
 }
 
 
 // interpolation des points de controles a l'aide d'une courbe spline cardinale
-// on determine egalement la nouvelle direction de la barque lorsqu'elle depasse un point de controle
+// la direction de la barque est donnee par la tangente a la courbe (derivee de la spline)
 // afin qu'elle suive la courbe du mouvement
-void update_boat_drift(vcl::mesh_drawable& boat, float t)
+void update_boat_drift(vcl::vec3& position, float& heading, float t)
 {
     // INTERPOLATION
     // Compute the interpolated position
-    vec3 const p = interpolation(t, key_positions, key_times);
-    boat.transform.translate = p;
-
-    // Compute the orientation
-    int N_t = key_times.size() - 2;
-    float theta = 0.0f;
-    bool change = false;
-    if (idx_last_key_time_boat < N_t && ((int) t) % ((int) key_times[N_t]) > key_times[idx_last_key_time_boat + 1]) {
-        int next = idx_last_key_time_boat + 2;
-        if (next >= N_t - 2) next = 1;
-        theta = -std::acos((key_positions[next][1] - key_positions[idx_last_key_time_boat + 1][1]) / norm(key_positions[next] - key_positions[idx_last_key_time_boat + 1]));
-        if ((key_positions[next][0] - key_positions[idx_last_key_time_boat + 1][0]) / norm(key_positions[next] - key_positions[idx_last_key_time_boat + 1]) < 0)
-            theta = - theta;
-        idx_last_key_time_boat++;
-        change = true;
-    }
-    if (idx_last_key_time_boat >= N_t - 2) {
-        idx_last_key_time_boat = 1;
-        theta = std::asin((key_positions[2][0] - key_positions[1][0]) / norm((key_positions[2] - key_positions[1])));
-    }
-
-    update_boat_direction(boat, p, theta, change);
+    position = interpolation(t, key_positions, key_times);
+
+    // Compute the orientation : the bow (axis y of the boat) follows the tangent
+    vec3 const dp = interpolation_derivative(t, key_positions, key_times);
+    heading = heading_from_tangent(dp);
 }
 
-// update la position et l'orientation de la barque qui derive
-void update_boat_direction(vcl::mesh_drawable &boat, vcl::vec3 position, float theta, bool change_orientation)
+// angle autour de z qui aligne la proue (axe y) avec la direction d
+float heading_from_tangent(vcl::vec3 const& d)
 {
-    /** *************************************************************  **/
-    /** Compute the (animated) transformations applied to the elements **/
-    /** *************************************************************  **/
-
-    if (change_orientation) {
-        boat.transform.rotate = rotation({ 0,0,1 }, theta);
-    }
-
-    boat.transform.translate = position;
+    return std::atan2(-d.x, d.y);
 }
+
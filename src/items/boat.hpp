@@ -4,12 +4,17 @@
 
 //----------------initialisation de la forme du bateau et de sa position de depart-----------------
 vcl::mesh create_boat(float radius, float width, float height, unsigned int N = 100);
-void initialize_boat(vcl::mesh_drawable& boat, float size);
+vcl::mesh create_boat_shape(float size);
+void initialize_boat(vcl::mesh_drawable& boat, vcl::mesh const& shape);
 
 //----------------update de la position de la barque attachee-----------------
 vcl::vec3 get_translation_to_bow(float size);
-void update_pos_boat(vcl::mesh_drawable& boat, float t, float tmax);
+vcl::vec3 get_moored_boat_position();
+void initialize_boat_motion();
+void update_pos_boat(vcl::vec3& position, float t, float tmax);
 
 //----------------update de la position du bateau qui derive sur le fleuve-----------------
-void update_boat_drift(vcl::mesh_drawable& boat, float t);
-void update_boat_direction(vcl::mesh_drawable &boat, vcl::vec3 position, float theta, bool change_orientation);
+vcl::buffer<vcl::vec3> const& get_drift_key_positions();
+vcl::buffer<float> const& get_drift_key_times();
+float heading_from_tangent(vcl::vec3 const& d);
+void update_boat_drift(vcl::vec3& position, float& heading, float t);
@@ -0,0 +1,21 @@
+#include "boat.hpp"
+#include "../helpers/texture_registry.hpp"
+
+using namespace vcl;
+
+
+// initialisation du mesh_drawable : envoi de la forme au GPU, texture, position de depart
+void initialize_boat(vcl::mesh_drawable& boat, vcl::mesh const& shape)
+{
+	boat = vcl::mesh_drawable(shape);
+	//boat.shading.color = { 196.0 / 255, 128.0 / 255, 77.0/255 };
+	boat.transform.translate = get_moored_boat_position();
+
+	// Load an image from a file (shared with the other users of the same image), and get its identifier texture_image_id
+	GLuint const texture_image_id = texture_acquire("pictures/texture_boat_2.png",
+		GL_MIRRORED_REPEAT /*GL_CLAMP_TO_EDGE*/ /**GL_TEXTURE_WRAP_S*/,
+		GL_MIRRORED_REPEAT /*GL_CLAMP_TO_EDGE*/ /**GL_TEXTURE_WRAP_T*/);
+
+	// Associate the texture_image_id to the image texture used when displaying visual
+	boat.texture = texture_image_id;
+}
@@ -1,5 +1,7 @@
 #include "columns.hpp"
 #include "vegetation.hpp"
+#include "../helpers/mesh_builder.hpp"
+#include "../helpers/mesh_cache.hpp"
 
 
 using namespace vcl;
@@ -35,58 +37,37 @@ mesh create_disc(float radius)
 vcl::mesh create_column_cyl(float size)
 {
     float const h = size * 4.0f; // trunk height
-    float r = size * 4.0 / 5; // trunk radius
+    float const r = size * 4.0 / 5; // trunk radius
     const int detail_level = 2;
 
     // column Hat
-    mesh hat = create_disc(3 / 2 * r);
-    mesh hat_cyl = create_tree_trunk_cylinder(3 / 2 * r, h / 10);
-    mesh top_disc = create_disc(3 / 2 * r);
-    top_disc.position += {0.0f, 0.0f, h / 10};
-    hat.push_back(hat_cyl);
-    hat.push_back(top_disc);
-
-    // column body
-    std::vector<vcl::mesh> list_trunks;
-    std::vector<vcl::vec3> list_centers;
-    list_trunks.push_back(create_tree_trunk_cylinder(r, h));
-    list_centers.push_back(vec3(0.0f, 0.0f, 0.0f));
-    for (int i = 0; i < detail_level; i++) {
-        r /= 3;
-        rule_trunk(list_trunks, list_centers, r, h);
-    }
-    mesh column_body;
-    for (auto trunk : list_trunks) {
-        column_body.push_back(trunk);
-    }
-    column_body.fill_empty_field();
-    column_body.position += { 0.0f, 0.0f, h/10 }; // place hat at the top of the column
+    mesh const disc = create_disc(3 / 2 * r);
+    mesh const hat_cyl = create_tree_trunk_cylinder(3 / 2 * r, h / 10);
 
-    // entire column
-    mesh column = hat;
-    column.push_back(column_body);
-    hat.position += { 0.0f, 0.0f, h }; // place hat at the top of the column
-    column.push_back(hat);
+    // column body : the same thin trunk repeated at each center
+    std::vector<vcl::vec3> const centers = create_trunk_centers(r, detail_level);
+    mesh const trunk = create_tree_trunk_cylinder(r / std::pow(3.0f, float(detail_level)), h);
 
-    return column;
+    // entire column
+    mesh_builder column;
+    column.reserve(4 * disc.position.size() + 2 * hat_cyl.position.size() + centers.size() * trunk.position.size(),
+                   4 * disc.connectivity.size() + 2 * hat_cyl.connectivity.size() + centers.size() * trunk.connectivity.size());
+    column.append(disc);
+    column.append(hat_cyl);
+    column.append(disc, { 0.0f, 0.0f, h / 10 });
+    for (vec3 const& center : centers)
+        column.append(trunk, center + vec3(0.0f, 0.0f, h / 10)); // place body on the hat
+    column.append(disc, { 0.0f, 0.0f, h }); // place hat at the top of the column
+    column.append(hat_cyl, { 0.0f, 0.0f, h });
+    column.append(disc, { 0.0f, 0.0f, h + h / 10 });
+
+    return column.finish();
 }
 
-// initialisation du mesh_drawable des colonnes : taille, texture, position de depart
-void initialize_column_cyl(vcl::mesh_drawable& column, float size)
+// forme de la colonne a la taille voulue, conservee dans le cache de meshes (calcul CPU seulement)
+vcl::mesh create_column_shape(float size)
 {
-    column = mesh_drawable(create_column_cyl(size));
-    column.transform.translate.x = 6.0f;
-
-    // Load an image from a file
-    image_raw const im = image_load_png("pictures/texture_column_2.png");
-
-    // Send this image to the GPU, and get its identifier texture_image_id
-    GLuint const texture_image_id = opengl_texture_to_gpu(im,
-        GL_MIRRORED_REPEAT /*GL_CLAMP_TO_EDGE*/ /**GL_TEXTURE_WRAP_S*/,
-        GL_MIRRORED_REPEAT /*GL_CLAMP_TO_EDGE*/ /**GL_TEXTURE_WRAP_T*/);
-
-    // Associate the texture_image_id to the image texture used when displaying visual
-    column.texture = texture_image_id;
+    return cached_mesh("column", { size }, 0, [size]() { return create_column_cyl(size); });
 }
 
 // creation de la forme de l'obelisque
@@ -133,22 +114,9 @@ vcl::mesh create_obelisque(float base, float height)
     return obelisque;
 }
 
-// initialisation du mesh_drawable de l'obelisque : taille, texture, position de depart
-void initialize_obelisque(vcl::mesh_drawable &obelisque, float size)
+// forme de l'obelisque a la taille voulue (calcul CPU seulement)
+vcl::mesh create_obelisque_shape(float size)
 {
-    obelisque = mesh_drawable(create_obelisque(size * 2.0f, size * 10.0f));
-    obelisque.transform.translate.z = 1.0f;
-    obelisque.transform.translate.x = -4.0f;
-    obelisque.transform.translate.y = -4.0f;
-
-    // Load an image from a file
-    image_raw const im = image_load_png("pictures/texture_obelisque.png");
-
-    // Send this image to the GPU, and get its identifier texture_image_id
-    GLuint const texture_image_id = opengl_texture_to_gpu(im,
-        GL_MIRRORED_REPEAT /*GL_CLAMP_TO_EDGE*/ /**GL_TEXTURE_WRAP_S*/,
-        GL_MIRRORED_REPEAT /*GL_CLAMP_TO_EDGE*/ /**GL_TEXTURE_WRAP_T*/);
-
-    // Associate the texture_image_id to the image texture used when displaying visual
-    obelisque.texture = texture_image_id;
+    return create_obelisque(size * 2.0f, size * 10.0f);
 }
+
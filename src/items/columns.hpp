@@ -7,7 +7,9 @@
 
 vcl::mesh create_disc(float radius);
 vcl::mesh create_column_cyl(float size);
-void initialize_column_cyl(vcl::mesh_drawable& column, float size);
+vcl::mesh create_column_shape(float size);
+void initialize_column_cyl(vcl::mesh_drawable& column, vcl::mesh const& shape);
 
 vcl::mesh create_obelisque(float base, float height);
-void initialize_obelisque(vcl::mesh_drawable &obelisque, float size);
+vcl::mesh create_obelisque_shape(float size);
+void initialize_obelisque(vcl::mesh_drawable &obelisque, vcl::mesh const& shape);
@@ -0,0 +1,37 @@
+#include "columns.hpp"
+#include "../helpers/texture_registry.hpp"
+
+using namespace vcl;
+
+
+// initialisation du mesh_drawable des colonnes : envoi de la forme au GPU, texture, position de depart
+void initialize_column_cyl(vcl::mesh_drawable& column, vcl::mesh const& shape)
+{
+    column = mesh_drawable(shape);
+    column.transform.translate.x = 6.0f;
+
+    // Load an image from a file (shared with the other users of the same image), and get its identifier texture_image_id
+    GLuint const texture_image_id = texture_acquire("pictures/texture_column_2.png",
+        GL_MIRRORED_REPEAT /*GL_CLAMP_TO_EDGE*/ /**GL_TEXTURE_WRAP_S*/,
+        GL_MIRRORED_REPEAT /*GL_CLAMP_TO_EDGE*/ /**GL_TEXTURE_WRAP_T*/);
+
+    // Associate the texture_image_id to the image texture used when displaying visual
+    column.texture = texture_image_id;
+}
+
+// initialisation du mesh_drawable de l'obelisque : envoi de la forme au GPU, texture, position de depart
+void initialize_obelisque(vcl::mesh_drawable &obelisque, vcl::mesh const& shape)
+{
+    obelisque = mesh_drawable(shape);
+    obelisque.transform.translate.z = 1.0f;
+    obelisque.transform.translate.x = -4.0f;
+    obelisque.transform.translate.y = -4.0f;
+
+    // Load an image from a file (shared with the other users of the same image), and get its identifier texture_image_id
+    GLuint const texture_image_id = texture_acquire("pictures/texture_obelisque.png",
+        GL_MIRRORED_REPEAT /*GL_CLAMP_TO_EDGE*/ /**GL_TEXTURE_WRAP_S*/,
+        GL_MIRRORED_REPEAT /*GL_CLAMP_TO_EDGE*/ /**GL_TEXTURE_WRAP_T*/);
+
+    // Associate the texture_image_id to the image texture used when displaying visual
+    obelisque.texture = texture_image_id;
+}
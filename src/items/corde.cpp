@@ -1,6 +1,7 @@
 
 #include "corde.hpp"
 #include "terrain.hpp"
+#include "../helpers/linear_arena.hpp"
 
 using namespace vcl;
 
@@ -27,9 +28,9 @@ vcl::vec3 spring_force(vcl::vec3 const& p_i, vcl::vec3 const& p_j, float L_0, fl
 // met a jour les positions et empechant que la corde coule sous l'eau
 void update_pos_rope(vcl::vec3 pos_bateau, vcl::buffer<vcl::vec3>& particules, vcl::buffer<vcl::vec3>& vitesses, vcl::buffer<float>& L0_array, vcl::buffer<float>& raideurs, vcl::mesh& terrain, float t, float dt, float tmax)
 {
-    // Forces
-    buffer<vec3> forces;
-    forces = {};
+    // Forces (tableau temporaire pris dans l'arene de la frame : pas d'allocation a chaque sous-pas)
+    arena_vector<vec3> forces{ arena_allocator<vec3>(frame_arena()) };
+    forces.reserve(NbrSpring);
     forces.push_back({0,0,0});
     for(int i=1; i<NbrSpring-1; i++){
         vec3 pprece = particules[i-1];
@@ -0,0 +1,128 @@
+#include "fleet.hpp"
+#include "boat.hpp"
+#include "../helpers/interpolation.hpp"
+#include "../helpers/mesh_builder.hpp"
+#include "../helpers/mesh_cache.hpp"
+#include "../helpers/random.hpp"
+#include <algorithm>
+#include <cmath>
+
+using namespace vcl;
+
+
+// deux splines : la descente du fleuve de la barque qui derive et la remontee en sens inverse
+std::vector<river_path> create_river_paths()
+{
+    std::vector<river_path> paths(2);
+    paths[0].key_positions = get_drift_key_positions();
+    paths[0].key_times = get_drift_key_times();
+
+    buffer<vec3> const& down = get_drift_key_positions();
+    size_t const N = down.size();
+    paths[1].key_times = get_drift_key_times();
+    paths[1].key_positions.resize(N);
+    for (size_t k = 0; k < N; k++)
+        paths[1].key_positions[k] = down[N - 1 - k];
+
+    return paths;
+}
+
+// position et derivee sur la spline au temps t, avec t dans [key_times[1], key_times[N-2]]
+// recherche dichotomique de l'intervalle : pas d'indice a memoriser d'une frame a l'autre
+void evaluate_river_path(river_path const& path, float t, vec3& p, vec3& dp)
+{
+    size_t const N = path.key_times.size();
+    float const* times = ptr(path.key_times);
+    size_t idx = std::upper_bound(times + 1, times + N - 2, t) - times - 1;
+    if (idx < 1) idx = 1;
+
+    float const t0 = times[idx - 1], t1 = times[idx], t2 = times[idx + 1], t3 = times[idx + 2];
+    vec3 const& p0 = path.key_positions[idx - 1];
+    vec3 const& p1 = path.key_positions[idx];
+    vec3 const& p2 = path.key_positions[idx + 1];
+    vec3 const& p3 = path.key_positions[idx + 2];
+
+    p = cardinal_spline_interpolation(t, t0, t1, t2, t3, p0, p1, p2, p3, 0.5f);
+    dp = cardinal_spline_derivative(t, t0, t1, t2, t3, p0, p1, p2, p3, 0.5f);
+}
+
+// repartition aleatoire des agents sur les splines : decalage temporel, vitesse et position laterale
+void initialize_fleet(fleet& agents, std::vector<river_path> const& paths, int const nb_agents[fleet_kind_count])
+{
+    int total = 0;
+    for (int k = 0; k < fleet_kind_count; k++) {
+        agents.kind_begin[k] = total;
+        total += nb_agents[k];
+    }
+    agents.kind_begin[fleet_kind_count] = total;
+
+    agents.path.resize(total);
+    agents.time_offset.resize(total);
+    agents.speed.resize(total);
+    agents.lateral.resize(total);
+    agents.local_time.resize(total);
+    agents.position.resize(total);
+    agents.heading.resize(total);
+
+    float const duration = paths[0].key_times[paths[0].key_times.size() - 2] - paths[0].key_times[1];
+    for (int i = 0; i < total; i++) {
+        rng_stream rng = rng_create("fleet", i);
+        agents.path[i] = i % paths.size();
+        agents.time_offset[i] = rng_uniform(rng, 0.0f, duration);
+        agents.speed[i] = rng_uniform(rng, 0.7f, 1.3f);
+        agents.lateral[i] = rng_uniform(rng, -0.4f, 0.4f);
+    }
+}
+
+// mise a jour par lots sur les tableaux contigus : temps local puis evaluation des splines
+void update_fleet(fleet& agents, std::vector<river_path> const& paths, float t)
+{
+    size_t const N = agents.position.size();
+
+    for (size_t i = 0; i < N; i++) {
+        river_path const& path = paths[agents.path[i]];
+        float const t_min = path.key_times[1];
+        float const duration = path.key_times[path.key_times.size() - 2] - t_min;
+        float tau = std::fmod(agents.time_offset[i] + agents.speed[i] * (t - t_min), duration);
+        if (tau < 0) tau += duration;
+        agents.local_time[i] = t_min + tau;
+    }
+
+    for (size_t i = 0; i < N; i++) {
+        vec3 p, dp;
+        evaluate_river_path(paths[agents.path[i]], agents.local_time[i], p, dp);
+
+        // decalage lateral perpendiculaire a la tangente
+        float const n = std::sqrt(dp.x * dp.x + dp.y * dp.y);
+        if (n > 1e-6f)
+            p += agents.lateral[i] * vec3(-dp.y / n, dp.x / n, 0.0f);
+
+        agents.position[i] = p;
+        agents.heading[i] = heading_from_tangent(dp);
+    }
+}
+
+// felouque : coque plus fine et plus haute que la barque, avec un mat et une voile
+vcl::mesh create_felouque(float size)
+{
+    mesh const hull = create_boat(size * 9.0f, size * 1.6f, size * 1.2f, 50);
+    mesh const mast = mesh_primitive_cylinder(size * 0.05f, { 0,0,0 }, { 0,0,size * 8.0f }, 6, 2, true);
+    mesh const sail = mesh_primitive_quadrangle({ 0, size * 0.3f, size * 1.5f }, { 0, size * 0.3f, size * 7.5f },
+                                                { 0, -size * 3.5f, size * 1.6f }, { 0, -size * 3.5f, size * 1.5f });
+    mesh_builder felouque;
+    felouque.reserve(hull.position.size() + mast.position.size() + sail.position.size(),
+                     hull.connectivity.size() + mast.connectivity.size() + sail.connectivity.size());
+    felouque.append(hull);
+    felouque.append(mast);
+    felouque.append(sail);
+    return felouque.finish();
+}
+
+// formes des trois types de bateaux (calcul CPU seulement)
+void create_fleet_shapes(vcl::mesh shapes[fleet_kind_count], float size)
+{
+    shapes[fleet_barque] = cached_mesh("boat", { size * 7.0f, size * 2.0f, size * 1.0f, 50.0f }, 0, [size]() { return create_boat(size * 7.0f, size * 2.0f, size * 1.0f, 50); });
+    shapes[fleet_felouque] = cached_mesh("felouque", { size }, 0, [size]() { return create_felouque(size); });
+    shapes[fleet_barge] = cached_mesh("boat", { size * 12.0f, size * 4.0f, size * 0.8f, 50.0f }, 0, [size]() { return create_boat(size * 12.0f, size * 4.0f, size * 0.8f, 50); });
+}
+
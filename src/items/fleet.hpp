@@ -0,0 +1,64 @@
+#pragma once
+
+#include "vcl/vcl.hpp"
+#include "../helpers/instancing.hpp"
+
+//----------------splines du fleuve suivies par les bateaux-----------------
+
+// le premier et le dernier point de controle ne sont pas parcourus (comme pour la barque qui derive)
+struct river_path
+{
+    vcl::buffer<vcl::vec3> key_positions;
+    vcl::buffer<float> key_times;
+};
+
+std::vector<river_path> create_river_paths();
+void evaluate_river_path(river_path const& path, float t, vcl::vec3& p, vcl::vec3& dp);
+
+//----------------flotte de bateaux (structure de tableaux)-----------------
+
+enum fleet_kind { fleet_barque = 0, fleet_felouque, fleet_barge, fleet_kind_count };
+
+// les agents sont ranges par type : ceux du type k sont dans [kind_begin[k], kind_begin[k+1][
+struct fleet
+{
+    // parametres propres a chaque agent
+    vcl::buffer<int> path;
+    vcl::buffer<float> time_offset;
+    vcl::buffer<float> speed;
+    vcl::buffer<float> lateral;     // decalage par rapport au centre de la spline
+
+    // etat recalcule a chaque frame
+    vcl::buffer<float> local_time;
+    vcl::buffer<vcl::vec3> position;
+    vcl::buffer<float> heading;
+
+    size_t kind_begin[fleet_kind_count + 1] = {};
+};
+
+void initialize_fleet(fleet& agents, std::vector<river_path> const& paths, int const nb_agents[fleet_kind_count]);
+void update_fleet(fleet& agents, std::vector<river_path> const& paths, float t);
+
+//----------------affichage instancie : un appel de dessin par type de bateau-----------------
+
+struct fleet_drawable
+{
+    vcl::mesh_drawable kinds[fleet_kind_count];
+};
+
+vcl::mesh create_felouque(float size);
+void create_fleet_shapes(vcl::mesh shapes[fleet_kind_count], float size);
+void initialize_fleet_drawable(fleet_drawable& visual, GLuint shader, GLuint texture, vcl::mesh const shapes[fleet_kind_count]);
+// positions et caps des bateaux du type kind envoyes par le buffer de streaming (reecrits a chaque frame)
+void stream_fleet_kind(fleet_drawable& visual, fleet const& agents, int kind, stream_buffer& stream);
+
+// chaque type est dessine juste apres l'envoi de ses donnees : si le buffer de streaming est agrandi
+// (orphelin) par un envoi, les types precedents ont deja ete dessines
+template <typename SCENE>
+void draw_fleet(fleet_drawable& visual, fleet const& agents, stream_buffer& stream, SCENE const& current_scene)
+{
+    for (int k = 0; k < fleet_kind_count; k++) {
+        stream_fleet_kind(visual, agents, k, stream);
+        draw_instanced(visual.kinds[k], agents.kind_begin[k + 1] - agents.kind_begin[k], current_scene);
+    }
+}
@@ -0,0 +1,19 @@
+#include "fleet.hpp"
+
+using namespace vcl;
+
+
+void initialize_fleet_drawable(fleet_drawable& visual, GLuint shader, GLuint texture, vcl::mesh const shapes[fleet_kind_count])
+{
+    for (int k = 0; k < fleet_kind_count; k++) {
+        visual.kinds[k] = mesh_drawable(shapes[k], shader, texture);
+        initialize_instancing(visual.kinds[k]);
+    }
+}
+
+// les agents d'un meme type etant contigus, on envoie directement une tranche des tableaux
+void stream_fleet_kind(fleet_drawable& visual, fleet const& agents, int kind, stream_buffer& stream)
+{
+    size_t const first = agents.kind_begin[kind];
+    stream_instancing(visual.kinds[kind], stream, ptr(agents.position) + first, ptr(agents.heading) + first, agents.kind_begin[kind + 1] - first);
+}
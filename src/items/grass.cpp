@@ -0,0 +1,172 @@
+#include "grass.hpp"
+#include "terrain.hpp"
+#include "../helpers/random.hpp"
+#include <algorithm>
+#include <cmath>
+
+using namespace vcl;
+
+
+namespace {
+
+// brins d'une tuile : tires uniformement dans la tuile et gardes sur la region herbe
+void create_grass_tile(std::vector<vec4>& blades, vec2 const& corner, grass_parameters const& parameters, mesh const& terrain, size_t tile)
+{
+    float const a = parameters.tile_size;
+
+    // classification grossiere de la tuile : ignoree si aucun point test n'est sur l'herbe,
+    // sans test par brin si tous le sont
+    int const M = 8;
+    int inside = 0;
+    for (int i = 0; i < M; i++)
+        for (int j = 0; j < M; j++)
+            inside += region_at(corner.x + (i + 0.5f) * a / M, corner.y + (j + 0.5f) * a / M) == region_herbe;
+    if (inside == 0)
+        return;
+    bool const test_each = inside < M * M;
+
+    rng_stream rng = rng_create("grass", tile);
+    size_t const candidates = size_t(parameters.density * a * a);
+    blades.reserve(candidates);
+    for (size_t k = 0; k < candidates; k++) {
+        float const x = corner.x + a * rng_uniform(rng);
+        float const y = corner.y + a * rng_uniform(rng);
+        float const angle = rng_uniform(rng, 0.0f, 2 * 3.14159f);
+        if (test_each && region_at(x, y) != region_herbe)
+            continue;
+        blades.push_back({ x, y, terrain_height(x, y, terrain), angle });
+    }
+}
+
+}
+
+
+grass_field create_grass_field(vcl::mesh const& terrain, grass_parameters const& parameters, thread_pool& pool)
+{
+    grass_field field;
+    field.parameters = parameters;
+
+    // tuiles couvrant le terrain [-8,8]x[-15,15]
+    int const nx = int(std::ceil(16.0f / parameters.tile_size));
+    int const ny = int(std::ceil(30.0f / parameters.tile_size));
+    size_t const tiles = size_t(nx * ny);
+
+    std::vector<std::vector<vec4>> tile_blades(tiles);
+    parallel_for(pool, tiles, [&](size_t k) {
+        vec2 const corner = { -8.0f + (k / ny) * parameters.tile_size, -15.0f + (k % ny) * parameters.tile_size };
+        create_grass_tile(tile_blades[k], corner, parameters, terrain, k);
+    });
+
+    field.tile_begin.resize(tiles + 1);
+    field.tile_begin[0] = 0;
+    for (size_t k = 0; k < tiles; k++)
+        field.tile_begin[k + 1] = field.tile_begin[k] + tile_blades[k].size();
+
+    field.blades.resize(field.tile_begin[tiles]);
+    field.tile_center.resize(tiles);
+    field.tile_radius.resize(tiles);
+    parallel_for(pool, tiles, [&](size_t k) {
+        std::vector<vec4> const& blades = tile_blades[k];
+        std::copy(blades.begin(), blades.end(), field.blades.begin() + field.tile_begin[k]);
+
+        // sphere englobante : centre de la tuile a mi-hauteur des brins
+        vec2 const corner = { -8.0f + (k / ny) * parameters.tile_size, -15.0f + (k % ny) * parameters.tile_size };
+        float z_min = 0.0f, z_max = 0.0f;
+        for (size_t i = 0; i < blades.size(); i++) {
+            z_min = i == 0 ? blades[i].z : std::min(z_min, blades[i].z);
+            z_max = i == 0 ? blades[i].z : std::max(z_max, blades[i].z);
+        }
+        z_max += parameters.blade_height * 1.3f;
+        float const half = 0.5f * parameters.tile_size;
+        field.tile_center[k] = { corner.x + half, corner.y + half, 0.5f * (z_min + z_max) };
+        field.tile_radius[k] = std::sqrt(2 * half * half + 0.25f * (z_max - z_min) * (z_max - z_min));
+    });
+    return field;
+}
+
+float select_grass_tiles(grass_field const& field, vec3 const& eye, vec3 const& front, std::vector<grass_tile_draw>& draws)
+{
+    grass_parameters const& parameters = field.parameters;
+    draws.clear();
+
+    // eclaircissement avec la distance, evalue au point de la tuile le plus proche de la camera :
+    // aucun brin de la tuile ne demande plus de densite
+    std::vector<float> falloff;
+    size_t wanted = 0;
+    size_t const tiles = field.tile_center.size();
+    for (size_t k = 0; k < tiles; k++) {
+        size_t const n = field.tile_begin[k + 1] - field.tile_begin[k];
+        if (n == 0)
+            continue;
+
+        vec3 const d = field.tile_center[k] - eye;
+        float const dist = norm(d);
+        float const r = field.tile_radius[k];
+        float const near = std::max(dist - r, 0.0f);
+        if (near >= parameters.fade_end)
+            continue;
+        // cone de vision elargi du rayon de la tuile
+        if (dist > r && dot(d, front) < dist * std::cos(std::min(parameters.half_fov + std::asin(r / dist), 3.14159f)))
+            continue;
+
+        float const u = std::min(std::max((near - parameters.fade_start) / (parameters.fade_end - parameters.fade_start), 0.0f), 1.0f);
+        float const f = 1.0f - u * u * (3 - 2 * u);
+        size_t const count = std::min(n, size_t(std::ceil(f * n)));
+        if (count == 0)
+            continue;
+        draws.push_back({ k, count });
+        falloff.push_back(f);
+        wanted += count;
+    }
+
+    // au dela du budget, toutes les tuiles sont eclaircies du meme facteur (le shader applique le meme a chaque brin)
+    if (wanted <= parameters.budget)
+        return 1.0f;
+    float const scale = float(parameters.budget) / float(wanted);
+    size_t kept = 0;
+    for (size_t i = 0; i < draws.size(); i++) {
+        size_t const n = field.tile_begin[draws[i].tile + 1] - field.tile_begin[draws[i].tile];
+        size_t const count = std::min(n, size_t(falloff[i] * scale * n));
+        if (count > 0)
+            draws[kept++] = { draws[i].tile, count };
+    }
+    draws.resize(kept);
+    return scale;
+}
+
+// brin d'herbe : bande effilee de 5 sommets legerement courbee, uv.y de 0 a la base a 1 a la pointe
+vcl::mesh create_grass_blade(float width, float height)
+{
+    mesh blade;
+    blade.position = { { -width / 2, 0.0f, 0.0f }, { width / 2, 0.0f, 0.0f },
+                       { -width / 4, 0.1f * height, 0.55f * height }, { width / 4, 0.1f * height, 0.55f * height },
+                       { 0.0f, 0.3f * height, height } };
+    blade.uv = { { 0.0f, 0.0f }, { 1.0f, 0.0f }, { 0.25f, 0.55f }, { 0.75f, 0.55f }, { 0.5f, 1.0f } };
+    blade.color = { { 0.20f, 0.38f, 0.10f }, { 0.20f, 0.38f, 0.10f },
+                    { 0.35f, 0.55f, 0.18f }, { 0.35f, 0.55f, 0.18f },
+                    { 0.55f, 0.72f, 0.30f } };
+    blade.connectivity = { { 0, 1, 3 }, { 0, 3, 2 }, { 2, 3, 4 } };
+    blade.fill_empty_field();
+    blade.compute_normal();
+    return blade;
+}
+
+void initialize_grass_drawable(grass_drawable& visual, grass_field const& field, GLuint shader)
+{
+    visual.blade = mesh_drawable(create_grass_blade(field.parameters.blade_width, field.parameters.blade_height), shader);
+
+    // tous les brins dans un seul buffer statique : seul le nombre de brins dessines change d'une image a l'autre
+    glGenBuffers(1, &visual.instances);
+    glBindBuffer(GL_ARRAY_BUFFER, visual.instances);
+    glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(field.blades.size() * sizeof(vec4)), field.blades.data(), GL_STATIC_DRAW);
+
+    glBindVertexArray(visual.blade.vao);
+    glEnableVertexAttribArray(4);
+    glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(vec4), nullptr);
+    glVertexAttribDivisor(4, 1);
+    glEnableVertexAttribArray(5);
+    glVertexAttribPointer(5, 1, GL_FLOAT, GL_FALSE, sizeof(vec4), reinterpret_cast<void const*>(3 * sizeof(float)));
+    glVertexAttribDivisor(5, 1);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "vcl/vcl.hpp"
+#include "../helpers/thread_pool.hpp"
+#include <vector>
+
+//----------------champ d'herbe sur la region herbe, genere par tuiles et dessine par instances-----------------
+
+struct grass_parameters
+{
+    float tile_size = 1.0f;         // cote d'une tuile du terrain
+    float density = 12000.0f;       // brins par unite de surface
+    float blade_width = 0.006f;
+    float blade_height = 0.05f;
+    float fade_start = 1.5f;        // distance a la camera a partir de laquelle l'herbe s'eclaircit
+    float fade_end = 6.0f;          // distance au dela de laquelle il n'y a plus de brins
+    float half_fov = 1.0f;          // demi-angle du cone de vision utilise pour eliminer les tuiles
+    size_t budget = 500000;         // nombre maximal de brins dessines par image
+};
+
+// brins ranges par tuile, dans un ordre aleatoire a l'interieur de chaque tuile :
+// dessiner les k premiers brins d'une tuile revient a l'eclaircir uniformement
+struct grass_field
+{
+    grass_parameters parameters;
+    std::vector<vcl::vec4> blades;          // (x, y, z, angle autour de z)
+    std::vector<size_t> tile_begin;         // brins de la tuile k : [tile_begin[k], tile_begin[k+1][
+    std::vector<vcl::vec3> tile_center;     // sphere englobante de chaque tuile
+    std::vector<float> tile_radius;
+};
+
+grass_field create_grass_field(vcl::mesh const& terrain, grass_parameters const& parameters, thread_pool& pool);
+
+// tuiles a dessiner pour une image : nombre de brins de chacune apres eclaircissement avec la distance et respect du budget
+struct grass_tile_draw
+{
+    size_t tile;
+    size_t count;
+};
+// renvoie le facteur applique a la densite pour tenir dans le budget (1 si le budget n'est pas atteint)
+float select_grass_tiles(grass_field const& field, vcl::vec3 const& eye, vcl::vec3 const& front, std::vector<grass_tile_draw>& draws);
+
+//----------------affichage : un appel de dessin instancie par tuile visible-----------------
+
+struct grass_drawable
+{
+    vcl::mesh_drawable blade;
+    GLuint instances = 0;                   // brins de toutes les tuiles, envoyes une seule fois
+    std::vector<grass_tile_draw> draws;     // tuiles retenues pour l'image courante
+
+    // statistiques de la derniere image
+    size_t drawn_blades = 0;
+    float budget_scale = 1.0f;
+};
+
+vcl::mesh create_grass_blade(float width, float height);
+void initialize_grass_drawable(grass_drawable& visual, grass_field const& field, GLuint shader);
+
+template <typename SCENE>
+void draw_grass(grass_drawable& visual, grass_field const& field, SCENE const& current_scene)
+{
+    visual.budget_scale = select_grass_tiles(field, current_scene.camera.position(), current_scene.camera.front(), visual.draws);
+    visual.drawn_blades = 0;
+    if (visual.draws.empty() || visual.blade.shader == 0) return;
+
+    GLuint const shader = visual.blade.shader;
+    glUseProgram(shader); opengl_check;
+    opengl_uniform(shader, current_scene);
+    opengl_uniform(shader, visual.blade.shading, false);
+    opengl_uniform(shader, "model", visual.blade.transform.matrix());
+    vcl::opengl_uniform(shader, "grass_eye", current_scene.camera.position());
+    glUniform2f(glGetUniformLocation(shader, "grass_fade"), field.parameters.fade_start, field.parameters.fade_end);
+    vcl::opengl_uniform(shader, "grass_scale", visual.budget_scale);
+
+    glActiveTexture(GL_TEXTURE0); opengl_check;
+    glBindTexture(GL_TEXTURE_2D, visual.blade.texture); opengl_check;
+    vcl::opengl_uniform(shader, "image_texture", 0); opengl_check;
+
+    glBindVertexArray(visual.blade.vao); opengl_check;
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, visual.blade.vbo.at("index")); opengl_check;
+    glBindBuffer(GL_ARRAY_BUFFER, visual.instances);
+    GLint const tile_blades = glGetUniformLocation(shader, "grass_tile_blades");
+    for (grass_tile_draw const& draw : visual.draws) {
+        // les attributs d'instance pointent sur le debut de la tuile (GL 3.3 : pas de base instance)
+        size_t const first = field.tile_begin[draw.tile];
+        glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(vcl::vec4), reinterpret_cast<void const*>(first * sizeof(vcl::vec4)));
+        glVertexAttribPointer(5, 1, GL_FLOAT, GL_FALSE, sizeof(vcl::vec4), reinterpret_cast<void const*>(first * sizeof(vcl::vec4) + 3 * sizeof(float)));
+        glUniform1f(tile_blades, float(field.tile_begin[draw.tile + 1] - first));
+        glDrawElementsInstanced(GL_TRIANGLES, GLsizei(visual.blade.number_triangles * 3), GL_UNSIGNED_INT, nullptr, GLsizei(draw.count)); opengl_check;
+        visual.drawn_blades += draw.count;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
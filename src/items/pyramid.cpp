@@ -1,4 +1,5 @@
 #include "pyramid.hpp"
+#include "../helpers/texture_registry.hpp"
 
 using namespace vcl;
 
@@ -31,20 +32,23 @@ vcl::mesh create_pyramid(float base, float height)
 	return pyramid;
 }
 
-// initialisation du mesh_drawable : taille, texture, position de depart
-void initialize_pyramid(vcl::mesh_drawable &pyramid, float size)
+// forme de la pyramide a la taille voulue (calcul CPU seulement)
+vcl::mesh create_pyramid_shape(float size)
 {
-	pyramid = mesh_drawable(create_pyramid(size * 200.0f, size * 130.0f));
+	return create_pyramid(size * 200.0f, size * 130.0f);
+}
+
+// initialisation du mesh_drawable : envoi de la forme au GPU, texture, position de depart
+void initialize_pyramid(vcl::mesh_drawable &pyramid, vcl::mesh const& shape)
+{
+	pyramid = mesh_drawable(shape);
 	pyramid.transform.translate.z = 1.0f;
 	pyramid.transform.translate.x = -4.0f;
 	pyramid.transform.translate.y = -4.0f;
 	//pyramid.shading.color = { 0.88f, 0.8f, 0.24f }; // Yellow
 
-	// Load an image from a file
-	image_raw const im = image_load_png("pictures/texture_pyramid.png");
-
-	// Send this image to the GPU, and get its identifier texture_image_id
-	GLuint const texture_image_id = opengl_texture_to_gpu(im,
+	// Load an image from a file (shared with the other users of the same image), and get its identifier texture_image_id
+	GLuint const texture_image_id = texture_acquire("pictures/texture_pyramid.png",
 		GL_MIRRORED_REPEAT /*GL_CLAMP_TO_EDGE*/ /**GL_TEXTURE_WRAP_S*/,
 		GL_MIRRORED_REPEAT /*GL_CLAMP_TO_EDGE*/ /**GL_TEXTURE_WRAP_T*/);
 
@@ -5,4 +5,5 @@
 // commentaires sur le .cpp
 
 vcl::mesh create_pyramid(float base, float height);
-void initialize_pyramid(vcl::mesh_drawable &pyramid, float size);
+vcl::mesh create_pyramid_shape(float size);
+void initialize_pyramid(vcl::mesh_drawable &pyramid, vcl::mesh const& shape);
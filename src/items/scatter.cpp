@@ -0,0 +1,155 @@
+#include "scatter.hpp"
+#include "../helpers/poisson_disk.hpp"
+#include "../helpers/random.hpp"
+#include "../helpers/scene_file.hpp"
+#include <algorithm>
+#include <cmath>
+
+using namespace vcl;
+
+
+namespace {
+
+// grandeurs du terrain utilisees par les regles, evaluees une fois par sommet de la grille
+struct terrain_field
+{
+    int N = 0;
+    std::vector<unsigned char> region;
+    std::vector<float> slope;
+};
+
+terrain_field evaluate_terrain_field(vcl::mesh const& terrain, thread_pool& pool)
+{
+    terrain_field field;
+    int const N = int(std::sqrt(float(terrain.position.size())));
+    field.N = N;
+    field.region.resize(N * N);
+    field.slope.resize(N * N);
+    if (N < 2)
+        return field;
+
+    float const dx = 16.0f / (N - 1.0f);
+    float const dy = 30.0f / (N - 1.0f);
+    parallel_for(pool, size_t(N), [&](size_t row) {
+        int const ku = int(row);
+        int const ku0 = std::max(ku - 1, 0), ku1 = std::min(ku + 1, N - 1);
+        for (int kv = 0; kv < N; kv++) {
+            int const kv0 = std::max(kv - 1, 0), kv1 = std::min(kv + 1, N - 1);
+            int const idx = ku * N + kv;
+            vec3 const& p = terrain.position[idx];
+            field.region[idx] = (unsigned char)region_at(p.x, p.y);
+
+            // differences finies centrees (decentrees sur les bords)
+            float const gx = (terrain.position[ku1 * N + kv].z - terrain.position[ku0 * N + kv].z) / ((ku1 - ku0) * dx);
+            float const gy = (terrain.position[ku * N + kv1].z - terrain.position[ku * N + kv0].z) / ((kv1 - kv0) * dy);
+            field.slope[idx] = std::sqrt(gx * gx + gy * gy);
+        }
+    });
+    return field;
+}
+
+// masque des sommets ou la regle autorise l'espece
+std::vector<unsigned char> evaluate_rule_mask(species_rule const& rule, terrain_field const& field, vcl::mesh const& terrain, thread_pool& pool)
+{
+    int const N = field.N;
+    std::vector<unsigned char> mask(N * N);
+    parallel_for(pool, size_t(N), [&](size_t row) {
+        for (int kv = 0; kv < N; kv++) {
+            int const idx = int(row) * N + kv;
+            float const z = terrain.position[idx].z;
+            mask[idx] = (rule.regions & (1u << field.region[idx])) != 0
+                && field.slope[idx] >= rule.slope_min && field.slope[idx] <= rule.slope_max
+                && z >= rule.altitude_min && z <= rule.altitude_max;
+        }
+    });
+    return mask;
+}
+
+scatter_instances scatter_species(species_rule const& rule, terrain_field const& field, vcl::mesh const& terrain, thread_pool& pool)
+{
+    scatter_instances instances;
+    int const N = field.N;
+    if (N < 2 || rule.regions == 0)
+        return instances;
+
+    std::vector<unsigned char> const mask = evaluate_rule_mask(rule, field, terrain, pool);
+
+    poisson_disk_parameters sampling;
+    sampling.domain_min = rule.domain_min;
+    sampling.domain_max = rule.domain_max;
+    sampling.radius = rule.spacing;
+    sampling.density_min = 0.1f;
+    if (rule.density)
+        sampling.density = [&rule](vec2 const& p) { return rule.density(p.x, p.y); };
+    // pente et altitude lues au sommet le plus proche, region evaluee exactement pour ne pas deborder sur l'eau
+    sampling.accept = [&](vec2 const& p) {
+        int const ku = std::min(std::max(int(std::lround((p.x / 16 + 0.5f) * (N - 1))), 0), N - 1);
+        int const kv = std::min(std::max(int(std::lround((p.y / 30 + 0.5f) * (N - 1))), 0), N - 1);
+        return mask[ku * N + kv] && (rule.regions & region_bit(region_at(p.x, p.y))) != 0;
+    };
+    sampling.name = rule.name;
+    std::vector<vec2> samples = poisson_disk_sample(sampling, pool);
+
+    // flux distinct de ceux des tuiles de l'echantillonnage (nom de la regle, indice de tuile)
+    rng_stream rng = rng_create((rule.name + "_instances").c_str(), 0);
+
+    // tirage de max_count positions parmi les echantillons (melange partiel de Fisher-Yates)
+    size_t const n = rule.max_count > 0 ? std::min(rule.max_count, samples.size()) : samples.size();
+    if (n < samples.size())
+        for (size_t k = 0; k < n; k++)
+            std::swap(samples[k], samples[k + std::min(size_t(rng_uniform(rng) * (samples.size() - k)), samples.size() - k - 1)]);
+
+    instances.position.resize(n);
+    instances.rotation.resize(n);
+    instances.scale.resize(n);
+    instances.variant.resize(n);
+    for (size_t k = 0; k < n; k++)
+        instances.position[k] = { samples[k].x, samples[k].y, terrain_height(samples[k].x, samples[k].y, terrain) };
+    rng_fill_uniform(rng, instances.rotation.data(), n, 0.0f, 2 * 3.14159f);
+    rng_fill_uniform(rng, instances.scale.data(), n, rule.scale_min, rule.scale_max);
+    for (size_t k = 0; k < n; k++)
+        instances.variant[k] = std::min(int(rng_uniform(rng) * rule.variants), std::max(rule.variants - 1, 0));
+    return instances;
+}
+
+}
+
+
+std::vector<scatter_instances> scatter_vegetation(std::vector<species_rule> const& rules, vcl::mesh const& terrain, thread_pool& pool)
+{
+    terrain_field const field = evaluate_terrain_field(terrain, pool);
+
+    std::vector<scatter_instances> instances(rules.size());
+    for (size_t k = 0; k < rules.size(); k++)
+        instances[k] = scatter_species(rules[k], field, terrain, pool);
+    return instances;
+}
+
+std::vector<species_rule> nile_species_rules(scene_description const& layout)
+{
+    std::vector<species_rule> rules(species_count);
+
+    // palmiers : sur l'herbe de l'ile du bas et de la rive gauche, pas trop au nord, en bosquets
+    species_rule& palm = rules[species_palm_tree];
+    palm.name = "forest";
+    palm.regions = region_bit(region_herbe);
+    palm.domain_max.y = 7.0f;
+    palm.slope_max = 1.0f;
+    palm.density = forest_density;
+    palm.spacing = 0.35f;
+    palm.max_count = size_t(std::max(layout.scatter[prop_palm_tree], 0));
+    palm.scale_min = 0.85f;
+    palm.scale_max = 1.15f;
+
+    // fougeres : au bord de l'eau, sur les terrains plats
+    species_rule& fern = rules[species_fern];
+    fern.name = "fern";
+    fern.regions = region_bit(region_berge_haut) | region_bit(region_herbe);
+    fern.slope_max = 0.5f;
+    fern.spacing = 1.5f;
+    fern.max_count = size_t(std::max(layout.scatter[prop_fern], 0));
+    fern.scale_min = 0.5f;
+    fern.scale_max = 0.8f;
+
+    return rules;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "vcl/vcl.hpp"
+#include "terrain.hpp"
+#include "../helpers/thread_pool.hpp"
+#include <functional>
+#include <string>
+#include <vector>
+
+//----------------repartition de la vegetation sur le terrain a partir de regles par espece-----------------
+
+// regle de placement d'une espece
+struct species_rule
+{
+    std::string name;                                   // nom de l'espece (flux aleatoires)
+    unsigned int regions = 0;                           // union de region_bit(...) ou l'espece pousse
+    vcl::vec2 domain_min = { -8.0f, -15.0f };           // rectangle du terrain ou l'espece pousse
+    vcl::vec2 domain_max = { 8.0f, 15.0f };
+    float slope_min = 0.0f;                             // pente |grad z| autorisee
+    float slope_max = 1e9f;
+    float altitude_min = -1e9f;                         // altitude autorisee
+    float altitude_max = 1e9f;
+    std::function<float(float, float)> density;         // densite dans [0,1] (vide : uniforme)
+    float spacing = 0.5f;                               // distance minimale entre deux pieds la ou la densite vaut 1
+    size_t max_count = 0;                               // nombre maximal d'instances (0 : pas de limite)
+    float scale_min = 1.0f;                             // echelle aleatoire de chaque instance
+    float scale_max = 1.0f;
+    int variants = 1;                                   // nombre de variantes de la forme
+};
+
+inline unsigned int region_bit(terrain_region region) { return 1u << region; }
+
+// instances d'une espece (structure of arrays, directement utilisable pour des buffers d'instances)
+struct scatter_instances
+{
+    std::vector<vcl::vec3> position;
+    std::vector<float> rotation;
+    std::vector<float> scale;
+    std::vector<int> variant;
+
+    size_t size() const { return position.size(); }
+};
+
+// evalue les regles en parallele sur la grille du terrain puis place chaque espece par echantillonnage de Poisson
+// le resultat ne depend que des regles, du terrain et de la graine globale
+std::vector<scatter_instances> scatter_vegetation(std::vector<species_rule> const& rules, vcl::mesh const& terrain, thread_pool& pool);
+
+// especes de la scene du Nil, le nombre d'instances de chacune etant donne par les directives scatter du fichier de scene
+struct scene_description;
+enum scatter_species_index { species_palm_tree, species_fern, species_count };
+std::vector<species_rule> nile_species_rules(scene_description const& layout);
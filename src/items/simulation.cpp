@@ -0,0 +1,93 @@
+#include "simulation.hpp"
+#include "bird.hpp"
+#include "boat.hpp"
+#include "corde.hpp"
+#include "../helpers/random.hpp"
+#include <algorithm>
+#include <chrono>
+
+using namespace vcl;
+
+
+void initialize_simulation(nile_simulation& sim, int const nb_agents[fleet_kind_count])
+{
+    sim.key_positions_bird.clear();
+    sim.key_times_bird.clear();
+    sim.leader_heading = initialize_leader_path(sim.key_positions_bird, sim.key_times_bird);
+    size_t const N = sim.key_times_bird.size();
+    sim.t_min = sim.key_times_bird[1];      // premiere et derniere images cles parcourues
+    sim.t_max = sim.key_times_bird[N - 2];
+
+    initialize_boat_motion();
+    sim.river_paths = create_river_paths();
+    initialize_fleet(sim.boats, sim.river_paths, nb_agents);
+
+    sim.pos_poteau = { 5.5f,-7.5f,0.1f };
+    sim.particules.clear();
+    sim.vitesses.clear();
+    sim.L0_array.clear();
+    sim.raideurs.clear();
+    initialize_corde(get_moored_boat_position() + get_translation_to_bow(0.1f), sim.pos_poteau, sim.particules, sim.vitesses, sim.L0_array, sim.raideurs);
+}
+
+void create_simulation_entities(nile_simulation& sim, entity_store& world, mesh_ref const& bird, mesh_ref const& boat)
+{
+    // meneur (non dessine) puis suiveurs les uns a la suite des autres : la nuee forme deux tranches contigues
+    sim.leader_bird = create_entities(world, 1, component_transform | component_velocity | component_spline);
+    world.position[sim.leader_bird] = sim.key_positions_bird[1];
+    world.angle[sim.leader_bird] = sim.leader_heading;
+    world.velocity[sim.leader_bird] = { 0.1f, 0.1f, 0.1f };
+    world.spline[sim.leader_bird].key_positions = &sim.key_positions_bird;
+    world.spline[sim.leader_bird].key_times = &sim.key_times_bird;
+    sim.first_follower_bird = create_entities(world, sim.nb_follower_birds, component_transform | component_velocity | component_mesh);
+    for (int i = 0; i < sim.nb_follower_birds; i++) {
+        rng_stream rng = rng_create("birds", i);
+        float const dx = rng_uniform(rng), dy = rng_uniform(rng), dz = rng_uniform(rng);
+        entity const e = sim.first_follower_bird + i;
+        world.position[e] = sim.key_positions_bird[0] + 1.0f*vec3(dx, dy, dz);
+        world.angle[e] = sim.leader_heading;
+        world.velocity[e] = { 0.1f, 0.1f, 0.1f };
+        world.mesh[e] = bird;
+    }
+
+    // barques animees par leurs propres fonctions, la premiere particule de la corde suit la proue de la barque attachee
+    sim.drifting_boat = create_entities(world, 1, component_transform | component_mesh);
+    world.mesh[sim.drifting_boat] = boat;
+    sim.moored_boat = create_entities(world, 1, component_transform | component_mesh);
+    world.position[sim.moored_boat] = get_moored_boat_position();
+    world.mesh[sim.moored_boat] = boat;
+    sim.rope = create_entities(world, 1, component_rope_anchor);
+    world.anchor[sim.rope] = { sim.moored_boat, get_translation_to_bow(0.1f) };
+}
+
+void step_simulation(nile_simulation& sim, entity_store& world, vcl::mesh& terrain, float t, float dt)
+{
+    // oiseaux : le meneur suit ses images cles, les suiveurs sont simules sur leurs tranches contigues
+    for_each_entity(world, component_transform | component_velocity | component_spline, [&](entity e) {
+        update_leader_bird(world.position[e], t, dt, *world.spline[e].key_positions, *world.spline[e].key_times, world.velocity[e], world.angle[e]);
+    });
+    bool const entities_ready = sim.rope < world.size() && world.has(sim.rope, component_rope_anchor); // la corde est la derniere entite creee
+    if (entities_ready) {
+        for (int i = 0; i < sim.substeps; i++) {
+            update_follower_birds(world.position[sim.leader_bird], world.velocity[sim.leader_bird], &world.position[sim.first_follower_bird], &world.velocity[sim.first_follower_bird], sim.nb_follower_birds, t, dt, 0.0001f, 0.0001f, 0.005f);
+        }
+        std::fill(world.angle.begin() + sim.first_follower_bird, world.angle.begin() + sim.first_follower_bird + sim.nb_follower_birds, world.angle[sim.leader_bird]);
+
+        // barque qui derive
+        update_boat_drift(world.position[sim.drifting_boat], world.angle[sim.drifting_boat], t);
+    }
+
+    // flotte : une seule mise a jour pour tous les bateaux
+    auto const fleet_start = std::chrono::steady_clock::now();
+    update_fleet(sim.boats, sim.river_paths, t);
+    sim.fleet_ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - fleet_start).count();
+
+    // barque attachee et sa corde
+    if (entities_ready) {
+        update_pos_boat(world.position[sim.moored_boat], t, sim.t_max);
+        vec3 const rope_start = world.position[world.anchor[sim.rope].target] + world.anchor[sim.rope].offset;
+        for (int i = 0; i < sim.substeps; i++) {
+            update_pos_rope(rope_start, sim.particules, sim.vitesses, sim.L0_array, sim.raideurs, terrain, t, dt, sim.t_max);
+        }
+    }
+}
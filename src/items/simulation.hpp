@@ -0,0 +1,50 @@
+#pragma once
+
+#include "vcl/vcl.hpp"
+#include "fleet.hpp"
+#include "../helpers/entity_store.hpp"
+#include <vector>
+
+//----------------systemes simules de la scene : oiseaux, bateaux, corde (sans OpenGL)-----------------
+// utilises par le thread de simulation de l'application et par nile_sim (pas de fenetre)
+// a graine et pas de temps fixes, un pas ne depend que de l'etat precedent : deux executions donnent les memes positions
+
+struct nile_simulation
+{
+    // oiseaux : le meneur suit ses images cles, les suiveurs sont des entites consecutives du monde
+    vcl::buffer<vcl::vec3> key_positions_bird;
+    vcl::buffer<float> key_times_bird;
+    float leader_heading = 0.0f;
+    int nb_follower_birds = 10;
+    entity leader_bird = 0;
+    entity first_follower_bird = 0;
+
+    // barque qui derive, barque attachee et sa corde
+    entity drifting_boat = 0;
+    entity moored_boat = 0;
+    entity rope = 0;
+    vcl::buffer<vcl::vec3> particules;
+    vcl::buffer<vcl::vec3> vitesses;
+    vcl::buffer<float> L0_array;
+    vcl::buffer<float> raideurs;
+    vcl::vec3 pos_poteau;
+
+    // bateaux suivant les splines du fleuve
+    std::vector<river_path> river_paths;
+    fleet boats;
+
+    int substeps = 50;          // sous-pas des oiseaux et de la corde par pas de simulation
+    float t_min = 0.0f;         // intervalle de temps des images cles du meneur
+    float t_max = 0.0f;
+
+    // statistiques du dernier pas
+    float fleet_ms = 0.0f;
+};
+
+// trajectoires, flotte et corde (a appeler apres rng_set_global_seed)
+void initialize_simulation(nile_simulation& sim, int const nb_agents[fleet_kind_count]);
+// entites des oiseaux, des barques et de la corde, dessinees avec les drawables donnes
+void create_simulation_entities(nile_simulation& sim, entity_store& world, mesh_ref const& bird, mesh_ref const& boat);
+
+// un pas a l'instant t (dt : pas de temps des sous-pas)
+void step_simulation(nile_simulation& sim, entity_store& world, vcl::mesh& terrain, float t, float dt);
@@ -1,5 +1,7 @@
 #include "terrain.hpp"
 #include "../helpers/interpolation.hpp"
+#include "../helpers/noise.hpp"
+#include "../helpers/thread_pool.hpp"
 
 using namespace vcl;
 
@@ -17,11 +19,18 @@ perlin_noise_parameters get_noise_params()
     return parameters;
 }
 
+// bruit en (u,v) avec son gradient par rapport a (x,y) : x = 16(u-0.5), y = 30(v-0.5) (voir evaluate_terrain)
+static noise_sample terrain_noise(float u, float v, int octave, float persistency, float frequency_gain)
+{
+    noise_sample noise = noise_perlin_gradient({u, v}, octave, persistency, frequency_gain);
+    noise.gradient = { noise.gradient.x/16, noise.gradient.y/30 };
+    return noise;
+}
+
 // initialisation du terrain
-mesh create_terrain()
+mesh create_terrain(unsigned int N)
 {
     // Number of samples of the terrain is N x N
-    const unsigned int N = 100;
 
     mesh terrain; // temporary terrain storage (CPU only)
     terrain.position.resize(N*N);
@@ -87,27 +96,27 @@ vcl::vec3 evaluate_terrain(float u, float v)
     return {x,y,z};
 }
 
-// fonction pour updater d'un coup tous les mesh drawables
-// il y en a un pour chaque partie du terrain afin de pouvoir leur appliquer chacune une texture
-void update_terrain(vcl::mesh& terrain, vcl::mesh_drawable& terrain_visual1, vcl::mesh_drawable& terrain_visual2, vcl::mesh_drawable& terrain_visual3, vcl::mesh_drawable& terrain_visual4, vcl::mesh_drawable& terrain_visual5, vcl::mesh_drawable& terrain_visual6, perlin_noise_parameters const& parameters, float t, float tmax)
+// calcul de toutes les parties du terrain, les dernieres recouvrant les premieres
+// les sommets de l'eau gardent la hauteur de create_terrain : la surface du fleuve est animee par shader/water.vert.glsl
+void compute_terrain(vcl::mesh& terrain, perlin_noise_parameters const& parameters)
 {
-    update_terrain_herbe(terrain, terrain_visual1, parameters);
-    update_terrain_rive_droite(terrain, terrain_visual1, parameters);
-    update_terrain_berge_bas(terrain, terrain_visual2, parameters);
-    update_terrain_berge_milieu(terrain, terrain_visual3, parameters);
-    update_terrain_berge_haut(terrain, terrain_visual4, parameters);
-    update_terrain_dune(terrain, terrain_visual5, parameters);
-    update_terrain_water(terrain, terrain_visual6, parameters, t, tmax);
+    compute_terrain_herbe(terrain, parameters);
+    compute_terrain_rive_droite(terrain, parameters);
+    compute_terrain_berge_bas(terrain, parameters);
+    compute_terrain_berge_milieu(terrain, parameters);
+    compute_terrain_berge_haut(terrain, parameters);
+    compute_terrain_dune(terrain, parameters);
 }
 
-// update le mesh drawable correspondant a l'eau : seul qui est actualise dans la boucle d'animation
-void update_terrain_water(vcl::mesh& terrain, vcl::mesh_drawable& terrain_visual, perlin_noise_parameters const& parameters, float t, float tmax)
+// hauteurs, couleurs et normales des sommets correspondant au premier echelon de berge
+void compute_terrain_berge_bas(vcl::mesh& terrain, perlin_noise_parameters const& parameters)
 {
     // Number of samples in each direction (assuming a square grid)
     int const N = std::sqrt(terrain.position.size());
 
-    // Recompute the new vertices
-    for (int ku = 0; ku < N; ++ku) {
+    // Recompute the new vertices (one row per iteration, rows are independent)
+    parallel_for(default_thread_pool(), size_t(N), [&](size_t row) {
+        int const ku = int(row);
         for (int kv = 0; kv < N; ++kv) {
 
             // Compute local parametric coordinates (u,v) \in [0,1]
@@ -116,73 +125,30 @@ void update_terrain_water(vcl::mesh& terrain, vcl::mesh_drawable& terrain_visual
 
             int const idx = ku*N+kv;
 
-            // Compute the Perlin noise
-            //float const noise1 = noise_perlin({u, v}, parameters.octave, parameters.persistency, parameters.frequency_gain);
-            float const noise2 = noise_perlin({u, v}, 6.0f, 0.6f, 2.25 - 0.3*sin(pi/2 + pi*t/tmax));    // utilisation d'un deuxieme bruit de perlin pour generer les vagues
-
-            if(is_water(terrain.position[idx].x,terrain.position[idx].y)){
-                terrain.position[idx].z = parameters.terrain_height*0.2f*noise2;
-                // use noise as color value
-                //terrain.color[idx] = 0.3f*vec3(0,0.0,1.0f);
-            }
-        }
-    }
-
-    // Update the normal of the mesh structure
-    terrain.compute_normal();
-
-    // Update step: Allows to update a mesh_drawable without creating a new one
-    terrain_visual.update_position(terrain.position);
-    terrain_visual.update_normal(terrain.normal);
-    terrain_visual.update_color(terrain.color);
-}
-
-// update le mesh drawable correspondant au premier echelon de berge
-void update_terrain_berge_bas(vcl::mesh& terrain, vcl::mesh_drawable& terrain_visual, perlin_noise_parameters const& parameters)
-{
-    // Number of samples in each direction (assuming a square grid)
-    int const N = std::sqrt(terrain.position.size());
-
-    // Recompute the new vertices
-    for (int ku = 0; ku < N; ++ku) {
-        for (int kv = 0; kv < N; ++kv) {
-
-            // Compute local parametric coordinates (u,v) \in [0,1]
-            const float u = ku/(N-1.0f);
-            const float v = kv/(N-1.0f);
-
-            int const idx = ku*N+kv;
-
-            // Compute the Perlin noise
-            float const noise = noise_perlin({u, v}, parameters.octave, parameters.persistency, parameters.frequency_gain);
+            // Compute the Perlin noise and its gradient
+            noise_sample const noise = terrain_noise(u, v, parameters.octave, parameters.persistency, parameters.frequency_gain);
 
             if (!is_water(terrain.position[idx].x,terrain.position[idx].y)
                     && is_berge(terrain.position[idx].x,terrain.position[idx].y, taille_berge1)){
                 // use the noise as height value
-                terrain.position[idx].z = parameters.terrain_height*noise*0.3;
+                terrain.position[idx].z = parameters.terrain_height*noise.value*0.3;
+                terrain.normal[idx] = normal_from_gradient(parameters.terrain_height*0.3f*noise.gradient);
                 // use noise as color value
-                terrain.color[idx] = vec3(0.31f,0.17f,0.04f)+0.5f*noise*vec3(1,1,1);
+                terrain.color[idx] = vec3(0.31f,0.17f,0.04f)+0.5f*noise.value*vec3(1,1,1);
             }
         }
-    }
-
-    // Update the normal of the mesh structure
-    terrain.compute_normal();
-
-    // Update step: Allows to update a mesh_drawable without creating a new one
-    terrain_visual.update_position(terrain.position);
-    terrain_visual.update_normal(terrain.normal);
-    terrain_visual.update_color(terrain.color);
+    });
 }
 
-// update le mesh drawable correspondant au deuxieme echelon de berge
-void update_terrain_berge_milieu(vcl::mesh& terrain, vcl::mesh_drawable& terrain_visual, perlin_noise_parameters const& parameters)
+// hauteurs, couleurs et normales des sommets correspondant au deuxieme echelon de berge
+void compute_terrain_berge_milieu(vcl::mesh& terrain, perlin_noise_parameters const& parameters)
 {
     // Number of samples in each direction (assuming a square grid)
     int const N = std::sqrt(terrain.position.size());
 
-    // Recompute the new vertices
-    for (int ku = 0; ku < N; ++ku) {
+    // Recompute the new vertices (one row per iteration, rows are independent)
+    parallel_for(default_thread_pool(), size_t(N), [&](size_t row) {
+        int const ku = int(row);
         for (int kv = 0; kv < N; ++kv) {
 
             // Compute local parametric coordinates (u,v) \in [0,1]
@@ -191,38 +157,32 @@ void update_terrain_berge_milieu(vcl::mesh& terrain, vcl::mesh_drawable& terrain
 
             int const idx = ku*N+kv;
 
-            // Compute the Perlin noise
-            float const noise = noise_perlin({u, v}, parameters.octave, parameters.persistency, parameters.frequency_gain);
+            // Compute the Perlin noise and its gradient
+            noise_sample const noise = terrain_noise(u, v, parameters.octave, parameters.persistency, parameters.frequency_gain);
 
             if (!is_water(terrain.position[idx].x,terrain.position[idx].y)
                     && !is_berge(terrain.position[idx].x,terrain.position[idx].y, taille_berge1)
                     && is_berge(terrain.position[idx].x,terrain.position[idx].y, taille_berge2)){
                 // use the noise as height value
-                terrain.position[idx].z = parameters.terrain_height*noise*0.6;
+                terrain.position[idx].z = parameters.terrain_height*noise.value*0.6;
+                terrain.normal[idx] = normal_from_gradient(parameters.terrain_height*0.6f*noise.gradient);
                 // use noise as color value
-                terrain.color[idx] = vec3(0.34f,0.16f,0.0f)+0.5f*noise*vec3(1,1,1);
+                terrain.color[idx] = vec3(0.34f,0.16f,0.0f)+0.5f*noise.value*vec3(1,1,1);
             }
 
         }
-    }
-
-    // Update the normal of the mesh structure
-    terrain.compute_normal();
-
-    // Update step: Allows to update a mesh_drawable without creating a new one
-    terrain_visual.update_position(terrain.position);
-    terrain_visual.update_normal(terrain.normal);
-    terrain_visual.update_color(terrain.color);
+    });
 }
 
-// update le mesh drawable correspondant au dernier echelon de berge
-void update_terrain_berge_haut(vcl::mesh& terrain, vcl::mesh_drawable& terrain_visual, perlin_noise_parameters const& parameters)
+// hauteurs, couleurs et normales des sommets correspondant au dernier echelon de berge
+void compute_terrain_berge_haut(vcl::mesh& terrain, perlin_noise_parameters const& parameters)
 {
     // Number of samples in each direction (assuming a square grid)
     int const N = std::sqrt(terrain.position.size());
 
-    // Recompute the new vertices
-    for (int ku = 0; ku < N; ++ku) {
+    // Recompute the new vertices (one row per iteration, rows are independent)
+    parallel_for(default_thread_pool(), size_t(N), [&](size_t row) {
+        int const ku = int(row);
         for (int kv = 0; kv < N; ++kv) {
 
             // Compute local parametric coordinates (u,v) \in [0,1]
@@ -231,39 +191,33 @@ void update_terrain_berge_haut(vcl::mesh& terrain, vcl::mesh_drawable& terrain_v
 
             int const idx = ku*N+kv;
 
-            // Compute the Perlin noise
-            float const noise = noise_perlin({u, v}, parameters.octave, parameters.persistency, parameters.frequency_gain);
+            // Compute the Perlin noise and its gradient
+            noise_sample const noise = terrain_noise(u, v, parameters.octave, parameters.persistency, parameters.frequency_gain);
 
             if (!is_water(terrain.position[idx].x,terrain.position[idx].y)
                     && !is_berge(terrain.position[idx].x,terrain.position[idx].y, taille_berge1)
                     && !is_berge(terrain.position[idx].x,terrain.position[idx].y, taille_berge2)
                     && is_berge(terrain.position[idx].x,terrain.position[idx].y, taille_berge3)){
                 // use the noise as height value
-                terrain.position[idx].z = parameters.terrain_height*noise;
+                terrain.position[idx].z = parameters.terrain_height*noise.value;
+                terrain.normal[idx] = normal_from_gradient(parameters.terrain_height*noise.gradient);
                 // use noise as color value
-                terrain.color[idx] = vec3(0.34f,0.16f,0.0f)+0.5f*noise*vec3(1,1,1);
+                terrain.color[idx] = vec3(0.34f,0.16f,0.0f)+0.5f*noise.value*vec3(1,1,1);
             }
 
         }
-    }
-
-    // Update the normal of the mesh structure
-    terrain.compute_normal();
-
-    // Update step: Allows to update a mesh_drawable without creating a new one
-    terrain_visual.update_position(terrain.position);
-    terrain_visual.update_normal(terrain.normal);
-    terrain_visual.update_color(terrain.color);
+    });
 }
 
-// update le mesh drawable correspondant a l'herbe
-void update_terrain_herbe(vcl::mesh& terrain, vcl::mesh_drawable& terrain_visual, perlin_noise_parameters const& parameters)
+// hauteurs, couleurs et normales des sommets correspondant a l'herbe
+void compute_terrain_herbe(vcl::mesh& terrain, perlin_noise_parameters const& parameters)
 {
     // Number of samples in each direction (assuming a square grid)
     int const N = std::sqrt(terrain.position.size());
 
-    // Recompute the new vertices
-    for (int ku = 0; ku < N; ++ku) {
+    // Recompute the new vertices (one row per iteration, rows are independent)
+    parallel_for(default_thread_pool(), size_t(N), [&](size_t row) {
+        int const ku = int(row);
         for (int kv = 0; kv < N; ++kv) {
 
             // Compute local parametric coordinates (u,v) \in [0,1]
@@ -272,8 +226,8 @@ void update_terrain_herbe(vcl::mesh& terrain, vcl::mesh_drawable& terrain_visual
 
             int const idx = ku*N+kv;
 
-            // Compute the Perlin noise
-            float const noise = noise_perlin({u, v}, parameters.octave, parameters.persistency, parameters.frequency_gain);
+            // Compute the Perlin noise and its gradient
+            noise_sample const noise = terrain_noise(u, v, parameters.octave, parameters.persistency, parameters.frequency_gain);
 
             if(!is_water(terrain.position[idx].x,terrain.position[idx].y)
                      && !is_berge(terrain.position[idx].x,terrain.position[idx].y, taille_berge1)
@@ -283,30 +237,25 @@ void update_terrain_herbe(vcl::mesh& terrain, vcl::mesh_drawable& terrain_visual
                      && !is_rive_droite(terrain.position[idx].x,terrain.position[idx].y) )
             {
                 // use also the noise as color value
-                terrain.color[idx] = 0.3f*vec3(0,0.5f,0)+0.7f*noise*vec3(1,1,1);
+                terrain.color[idx] = 0.3f*vec3(0,0.5f,0)+0.7f*noise.value*vec3(1,1,1);
                 // use the noise as height value
-                terrain.position[idx].z = parameters.terrain_height*noise + evaluate_dune(terrain.position[idx].x,terrain.position[idx].y, parameters.terrain_height);
+                vec2 dune_gradient;
+                terrain.position[idx].z = parameters.terrain_height*noise.value + evaluate_dune(terrain.position[idx].x,terrain.position[idx].y, parameters.terrain_height, dune_gradient);
+                terrain.normal[idx] = normal_from_gradient(parameters.terrain_height*noise.gradient + dune_gradient);
             }
         }
-    }
-
-    // Update the normal of the mesh structure
-    terrain.compute_normal();
-
-    // Update step: Allows to update a mesh_drawable without creating a new one
-    terrain_visual.update_position(terrain.position);
-    terrain_visual.update_normal(terrain.normal);
-    terrain_visual.update_color(terrain.color);
+    });
 }
 
-// update le mesh drawable correspondant a la rive droite
-void update_terrain_rive_droite(vcl::mesh& terrain, vcl::mesh_drawable& terrain_visual, perlin_noise_parameters const& parameters)
+// hauteurs, couleurs et normales des sommets correspondant a la rive droite
+void compute_terrain_rive_droite(vcl::mesh& terrain, perlin_noise_parameters const& parameters)
 {
     // Number of samples in each direction (assuming a square grid)
     int const N = std::sqrt(terrain.position.size());
 
-    // Recompute the new vertices
-    for (int ku = 0; ku < N; ++ku) {
+    // Recompute the new vertices (one row per iteration, rows are independent)
+    parallel_for(default_thread_pool(), size_t(N), [&](size_t row) {
+        int const ku = int(row);
         for (int kv = 0; kv < N; ++kv) {
 
             // Compute local parametric coordinates (u,v) \in [0,1]
@@ -315,8 +264,8 @@ void update_terrain_rive_droite(vcl::mesh& terrain, vcl::mesh_drawable& terrain_
 
             int const idx = ku*N+kv;
 
-            // Compute the Perlin noise
-            float const noise = noise_perlin({u, v}, parameters.octave, parameters.persistency, parameters.frequency_gain);
+            // Compute the Perlin noise and its gradient
+            noise_sample const noise = terrain_noise(u, v, parameters.octave, parameters.persistency, parameters.frequency_gain);
 
             if(!is_berge(terrain.position[idx].x,terrain.position[idx].y, taille_berge1)
                      && !is_berge(terrain.position[idx].x,terrain.position[idx].y, taille_berge2)
@@ -324,30 +273,25 @@ void update_terrain_rive_droite(vcl::mesh& terrain, vcl::mesh_drawable& terrain_
                      && is_rive_droite(terrain.position[idx].x,terrain.position[idx].y) )
             {
                 // use also the noise as color value
-                terrain.color[idx] = 0.3f*vec3(0.76f,0.7f,0.5f)+0.7f*noise*vec3(1,1,1);
+                terrain.color[idx] = 0.3f*vec3(0.76f,0.7f,0.5f)+0.7f*noise.value*vec3(1,1,1);
                 // use the noise as height value
-                terrain.position[idx].z = parameters.terrain_height*noise + evaluate_dune(terrain.position[idx].x,terrain.position[idx].y, parameters.terrain_height);
+                vec2 dune_gradient;
+                terrain.position[idx].z = parameters.terrain_height*noise.value + evaluate_dune(terrain.position[idx].x,terrain.position[idx].y, parameters.terrain_height, dune_gradient);
+                terrain.normal[idx] = normal_from_gradient(parameters.terrain_height*noise.gradient + dune_gradient);
             }
         }
-    }
-
-    // Update the normal of the mesh structure
-    terrain.compute_normal();
-
-    // Update step: Allows to update a mesh_drawable without creating a new one
-    terrain_visual.update_position(terrain.position);
-    terrain_visual.update_normal(terrain.normal);
-    terrain_visual.update_color(terrain.color);
+    });
 }
 
-// update le mesh drawable correspondant aux dunes
-void update_terrain_dune(vcl::mesh& terrain, vcl::mesh_drawable& terrain_visual, perlin_noise_parameters const& parameters)
+// hauteurs, couleurs et normales des sommets correspondant aux dunes
+void compute_terrain_dune(vcl::mesh& terrain, perlin_noise_parameters const& parameters)
 {
     // Number of samples in each direction (assuming a square grid)
     int const N = std::sqrt(terrain.position.size());
 
-    // Recompute the new vertices
-    for (int ku = 0; ku < N; ++ku) {
+    // Recompute the new vertices (one row per iteration, rows are independent)
+    parallel_for(default_thread_pool(), size_t(N), [&](size_t row) {
+        int const ku = int(row);
         for (int kv = 0; kv < N; ++kv) {
 
             // Compute local parametric coordinates (u,v) \in [0,1]
@@ -356,59 +300,82 @@ void update_terrain_dune(vcl::mesh& terrain, vcl::mesh_drawable& terrain_visual,
 
             int const idx = ku*N+kv;
 
-            // Compute the Perlin noise
-            float const noise = noise_perlin({u, v}, parameters.octave, parameters.persistency, parameters.frequency_gain);
+            // Compute the Perlin noise and its gradient
+            noise_sample const noise = terrain_noise(u, v, parameters.octave, parameters.persistency, parameters.frequency_gain);
 
             if (is_dune(terrain.position[idx].x,terrain.position[idx].y)){
                 // use also the noise as color value
-                terrain.color[idx] = vec3(0.87,0.70,0.5)+0.5f*noise*vec3(1,1,1);
+                terrain.color[idx] = vec3(0.87,0.70,0.5)+0.5f*noise.value*vec3(1,1,1);
                 // use the noise as height value
-                terrain.position[idx].z = parameters.terrain_height*noise*
-                        std::exp(-(terrain.position[idx].y-dune(terrain.position[idx].x))*(terrain.position[idx].y-dune(terrain.position[idx].x)))
-                        + evaluate_dune(terrain.position[idx].x,terrain.position[idx].y, parameters.terrain_height);
+                float const x = terrain.position[idx].x, y = terrain.position[idx].y;
+                float const e = y-dune(x);
+                float const attenuation = std::exp(-e*e);
+                vec2 dune_gradient;
+                terrain.position[idx].z = parameters.terrain_height*noise.value*attenuation
+                        + evaluate_dune(x, y, parameters.terrain_height, dune_gradient);
+                // d(attenuation) = -2 e attenuation d(e), avec d(e) = (-dune'(x), 1)
+                vec2 const attenuation_gradient = -2*e*attenuation*vec2(-dune_d(x), 1.0f);
+                terrain.normal[idx] = normal_from_gradient(parameters.terrain_height*(attenuation*noise.gradient + noise.value*attenuation_gradient) + dune_gradient);
             }
         }
-    }
-
-    // Update the normal of the mesh structure
-    terrain.compute_normal();
-
-    // Update step: Allows to update a mesh_drawable without creating a new one
-    terrain_visual.update_position(terrain.position);
-    terrain_visual.update_normal(terrain.normal);
-    terrain_visual.update_color(terrain.color);
+    });
 }
 
 
 // determine la hauteur de la dune la plus haute au point de coordonnees (x,y,.)
 float evaluate_dune(float x, float y, float height_param)
+{
+    vec2 gradient;
+    return evaluate_dune(x, y, height_param, gradient);
+}
+
+// meme hauteur, avec son gradient par rapport a (x,y) (celui de la dune la plus haute)
+float evaluate_dune(float x, float y, float height_param, vec2& gradient)
 {                                                               // utile meme hors de la zone de dunes pour eviter les discontinutes
-    buffer<vec2> bornes = { {-8,-1}, {-8,-2}, {-2.5,7}, {2,8}}; // en effet on a une fonction exponentielle et une 1/d^2 qui ne sont pas a support compact
-    float *possible_heights = new float[4];
+    vec2 const bornes[4] = { {-8,-1}, {-8,-2}, {-2.5,7}, {2,8}}; // en effet on a une fonction exponentielle et une 1/d^2 qui ne sont pas a support compact
+    float possible_heights[4];  // tableaux de taille fixe sur la pile : ni allocation ni fuite a chaque point
+    vec2 possible_gradients[4];
     float dist;
+    float dist_dx;              // derivee de dist par rapport a x (par rapport a y : 1)
     float height;
     float sig = 2.0f;
     for(int i=0; i<4; i++){
         if(x<bornes[i][0]) {
             dist = y - dunes(bornes[i][0])[i];
+            dist_dx = 0.0f;
             //height = heights_dunes(bornes[i][0])[i]*height_param;
         }
         else if(x>bornes[i][1]) {
             dist = y - dunes(bornes[i][1])[i];
+            dist_dx = 0.0f;
             //height = heights_dunes(bornes[i][1])[i]*height_param;
         }
         else {
             dist = y - dunes(x)[i];
+            dist_dx = -dunes_d(x)[i];
             //height = heights_dunes(x)[i]*height_param;
         }
         height = 2*height_param;
         float d = dist*dist/sig;
-        if(dist<0) possible_heights[i] = 1/((dist-1/std::sqrt(height))*(dist-1/std::sqrt(height)));
-        else possible_heights[i] = height*std::exp(-d*d);
+        float dh_ddist;
+        if(dist<0){
+            float const a = dist-1/std::sqrt(height);
+            possible_heights[i] = 1/(a*a);
+            dh_ddist = -2/(a*a*a);
+        }
+        else{
+            possible_heights[i] = height*std::exp(-d*d);
+            dh_ddist = -4*d*dist/sig*possible_heights[i];
+        }
+        possible_gradients[i] = dh_ddist*vec2(dist_dx, 1.0f);
     }
     float max = possible_heights[0];
+    gradient = possible_gradients[0];
     for(int i=1; i<4; i++){
-        if(max < possible_heights[i]) max = possible_heights[i];
+        if(max < possible_heights[i]){
+            max = possible_heights[i];
+            gradient = possible_gradients[i];
+        }
     }
     return max;
 }
@@ -444,12 +411,21 @@ float dune(float x)     //zone des dunes
 {
     return 10.767 + x*(0.3125 - x*0.0354);
 }
+float dune_d(float x)       // derivee de la limite des dunes
+{
+    return 0.3125 - x*0.0354*2;
+}
 
 vec4 dunes(float x)   //equation de la position des crêtes
 {
     return {12.238f + x*(0.2857f - x*0.0476f), 15.0f + x*(-0.0833f - x*0.0417f),
                 14.12f + x*(0.2158f - x*0.0129f), 16.5f + x*(-0.8333f + x*0.0417f)};
 }
+vec4 dunes_d(float x)   //derivee de la position des crêtes
+{
+    return {0.2857f - x*0.0476f*2, -0.0833f - x*0.0417f*2,
+                0.2158f - x*0.0129f*2, -0.8333f + x*0.0417f*2};
+}
 vec4 heights_dunes(float x)     //hauteurs des crêtes
 {
     return {2.9238f + x*(0.2536f - x*0.0298f), 2.1f + x*(0.2167f - x*0.0333f),
@@ -499,102 +475,32 @@ bool is_rive_droite(float x, float y)
     return false;
 }
 
-// permet de plaquer une texture 2D sur un mesh drawable (ici le sable sur le terrain)
-GLuint texture(const std::string& filename)
-{
-    // Load an image dune from a file
-    image_raw const im1 = image_load_png(filename);
-
-    // Send this image to the GPU, and get its identifier texture_image_id
-    GLuint const texture_image_id1 = opengl_texture_to_gpu(im1,
-        GL_MIRRORED_REPEAT /**GL_TEXTURE_WRAP_S*/,
-        GL_MIRRORED_REPEAT /**GL_TEXTURE_WRAP_T*/);
-    // Associate the texture_image_id to the image texture used when displaying visual
-    return texture_image_id1;
-}
-
-// génère les positions des arbres : sur l'ile du bas et sur la rive gauche de façon à ce qu'ils ne s'inter-pénètrent pas
-std::vector<vcl::vec3> generate_positions_forest(int N, vcl::mesh& terrain)
-{
-    std::vector<vcl::vec3> tab;
-    int i = 0;
-    float dmin = 0.01f;
-    int it = 0;
-    int Max_it = 5*N;
-    bool b;
-    while(i<N && it < Max_it){
-        it++;
-        float u = rand_interval();
-        float v = rand_interval();
-        vec3 pos = evaluate_terrain2(u, v, terrain);
-        b = true;
-        float dist;
-
-        if(is_water(pos[0],pos[1])
-                || is_berge(pos[0],pos[1], taille_berge3)
-                || is_dune(pos[0],pos[1])
-                || is_rive_droite(pos[0],pos[1])
-                || pos[1] > 7.0f )
-            b = false;
-
-        if(b){
-            for(int j=0; j<i; j++){ //for(vec3 q : tab)
-                dist = sqrt((pos[0]-tab[j][0])*(pos[0]-tab[j][0]) + (pos[1]-tab[j][1])*(pos[1]-tab[j][1]) + (pos[2]-tab[j][2])*(pos[2]-tab[j][2]));
-                if(dist < dmin){
-                    b = false;
-                    break;
-                }
-            }
-        }
-
-        if(b) {
-            tab.push_back(pos);
-            i++;
-        }
-    }
-    return tab;
-}
-
-// on génère les pyramides, les colonnes et l'obelisque de façon déterministe
-std::vector<vcl::vec3> generate_positions_pyramids(vcl::mesh& terrain, perlin_noise_parameters const& parameters)
+// region du terrain en (x,y), dans le meme ordre de priorite que compute_terrain (l'eau et les dunes recouvrent les berges)
+terrain_region region_at(float x, float y)
 {
-    std::vector<vcl::vec3> tab;
-    tab.push_back({6.3f,-6.2f,parameters.terrain_height*0.4 + evaluate_dune(7.0f,-6.2f, parameters.terrain_height)});
-    tab.push_back({3.4f,-4.5f,parameters.terrain_height*0.3 + evaluate_dune(3.4f,-4.5f, parameters.terrain_height)});
-    tab.push_back({6.0f,0.0f,parameters.terrain_height*0.6 + evaluate_dune(6.0f,0.0f, parameters.terrain_height)});
-    tab.push_back({2.0f,10.0f,parameters.terrain_height*0.7 + evaluate_dune(2.0f,10.0f, parameters.terrain_height)});
-    return tab;
+    if (is_water(x, y)) return region_water;
+    if (is_dune(x, y)) return region_dune;
+    if (is_berge(x, y, taille_berge1)) return region_berge_bas;
+    if (is_berge(x, y, taille_berge2)) return region_berge_milieu;
+    if (is_berge(x, y, taille_berge3)) return region_berge_haut;
+    if (is_rive_droite(x, y)) return region_rive_droite;
+    return region_herbe;
 }
 
-// on ne génère que quelques fougère car elles font trop chuter les fps de la scène
-std::vector<vcl::vec3> generate_positions_ferns(vcl::mesh& terrain, perlin_noise_parameters const& parameters)
+// densite de la foret dans [0,1] : des bosquets plus serres et des clairieres
+float forest_density(float x, float y)
 {
-    std::vector<vcl::vec3> tab;
-    tab.push_back({3.4f,-2.5f,parameters.terrain_height*0.7 + evaluate_dune(3.4f,-2.5f, parameters.terrain_height)+0.05f});
-    return tab;
+    return std::min(std::max(1.5f * noise_perlin_gradient({ 0.15f * x + 10.0f, 0.15f * y }, 3, 0.4f, 2.0f).value - 0.5f, 0.0f), 1.0f);
 }
 
-std::vector<vcl::vec3> generate_positions_columns(vcl::mesh& terrain, perlin_noise_parameters const& parameters)
-{
-    std::vector<vcl::vec3> tab;
-    tab.push_back({-6.0f,6.3f,parameters.terrain_height + evaluate_dune(-6.0f,6.3f, parameters.terrain_height)});
-    tab.push_back({-5.0f,7.0f,parameters.terrain_height + evaluate_dune(-5.0f,7.0f, parameters.terrain_height)});
-    tab.push_back({-4.0f,7.7f,parameters.terrain_height + evaluate_dune(-4.0f,7.7f, parameters.terrain_height)});
-    tab.push_back({-3.0f,8.3f,parameters.terrain_height + evaluate_dune(-3.0f,8.3f, parameters.terrain_height)});
-    tab.push_back({-2.0f,9.0f,parameters.terrain_height + evaluate_dune(-2.0f,9.0f, parameters.terrain_height)});
-    tab.push_back({4.0f,10.5f,parameters.terrain_height + evaluate_dune(4.0f,10.5f, parameters.terrain_height)});
-    tab.push_back({5.0f,10.5f,parameters.terrain_height + evaluate_dune(5.0f,10.5f, parameters.terrain_height)});
-    tab.push_back({6.0f,10.5f,parameters.terrain_height + evaluate_dune(6.0f,10.5f, parameters.terrain_height)});
-    tab.push_back({4.0f,9.5f,parameters.terrain_height + evaluate_dune(4.0f,9.5f, parameters.terrain_height)});
-    tab.push_back({5.0f,9.5f,parameters.terrain_height + evaluate_dune(5.0f,9.5f, parameters.terrain_height)});
-    tab.push_back({6.0f,9.5f,parameters.terrain_height + evaluate_dune(6.0f,9.5f, parameters.terrain_height)});
-
-    return tab;
-}
-
-std::vector<vcl::vec3> generate_positions_obelisque(vcl::mesh& terrain, perlin_noise_parameters const& parameters)
+// altitude du terrain en (x,y) par interpolation bilineaire des sommets du mesh
+float terrain_height(float x, float y, vcl::mesh const& terrain)
 {
-    std::vector<vcl::vec3> tab;
-    tab.push_back({-4.0f,-3.0f,parameters.terrain_height*0.6 + evaluate_dune(-4.0f,-3.0f, parameters.terrain_height)});
-    return tab;
+    int const N = int(std::sqrt(float(terrain.position.size())));
+    float const ku = std::min(std::max((x / 16 + 0.5f) * (N - 1.0f), 0.0f), N - 1.001f);
+    float const kv = std::min(std::max((y / 30 + 0.5f) * (N - 1.0f), 0.0f), N - 1.001f);
+    int const i = int(ku), j = int(kv);
+    float const a = ku - i, b = kv - j;
+    return (1 - a) * (1 - b) * terrain.position[i * N + j].z + a * (1 - b) * terrain.position[(i + 1) * N + j].z
+         + (1 - a) * b * terrain.position[i * N + j + 1].z + a * b * terrain.position[(i + 1) * N + j + 1].z;
 }
@@ -16,13 +16,15 @@ perlin_noise_parameters get_noise_params();
 
 //----------------initialisation du terrain et fonctions permettant de retrouver la position d'un point sur le mesh du terrain-----------------
 
-vcl::mesh create_terrain();
+vcl::mesh create_terrain(unsigned int N = 100);   // N x N sommets
 vcl::vec3 evaluate_terrain2(float u, float v, vcl::mesh& terrain);
 vcl::vec3 evaluate_terrain(float u, float v);
 float evaluate_dune(float x, float y, float height);
+float evaluate_dune(float x, float y, float height, vcl::vec2& gradient);   // hauteur et gradient par rapport a (x,y)
 
 vcl::vec4 heights_dunes(float x);
 vcl::vec4 dunes(float x);
+vcl::vec4 dunes_d(float x);
 
 //----------------fonctions de base polynomiales definissant les differentes parties du terrain-----------------
 
@@ -33,6 +35,7 @@ float rive_droite_d(float y);
 float ile(float x);
 float ile_d(float x);
 float dune(float x);
+float dune_d(float x);
 
 
 bool is_water(float x, float y);
@@ -40,25 +43,23 @@ bool is_rive_droite(float x, float y);
 bool is_berge(float x, float y, float taille_berge);
 bool is_dune(float x, float y);
 
-//----------------utilisation des fonctions ci dessus pour actualiser les points du terrain-----------------
+// parties du terrain, chacune affichee avec sa propre texture
+enum terrain_region { region_water, region_berge_bas, region_berge_milieu, region_berge_haut, region_herbe, region_rive_droite, region_dune, region_count };
+terrain_region region_at(float x, float y);
 
-void update_terrain(vcl::mesh& terrain, vcl::mesh_drawable& terrain_visual1, vcl::mesh_drawable& terrain_visual2, vcl::mesh_drawable& terrain_visual3, vcl::mesh_drawable& terrain_visual4, vcl::mesh_drawable& terrain_visual5, vcl::mesh_drawable& terrain_visual6, perlin_noise_parameters const& parameters, float t, float tmax);
+float forest_density(float x, float y);
+float terrain_height(float x, float y, vcl::mesh const& terrain);
 
-void update_terrain_water(vcl::mesh& terrain, vcl::mesh_drawable& terrain_visual, perlin_noise_parameters const& parameters, float t, float tmax);
-void update_terrain_berge_bas(vcl::mesh& terrain, vcl::mesh_drawable& terrain_visual, perlin_noise_parameters const& parameters);
-void update_terrain_berge_milieu(vcl::mesh& terrain, vcl::mesh_drawable& terrain_visual, perlin_noise_parameters const& parameters);
-void update_terrain_berge_haut(vcl::mesh& terrain, vcl::mesh_drawable& terrain_visual, perlin_noise_parameters const& parameters);
-void update_terrain_herbe(vcl::mesh& terrain, vcl::mesh_drawable& terrain_visual, perlin_noise_parameters const& parameters);
-void update_terrain_rive_droite(vcl::mesh& terrain, vcl::mesh_drawable& terrain_visual, perlin_noise_parameters const& parameters);
-void update_terrain_dune(vcl::mesh& terrain, vcl::mesh_drawable& terrain_visual, perlin_noise_parameters const& parameters);
+//----------------utilisation des fonctions ci dessus pour calculer les points du terrain (sans OpenGL, terrain.cpp)-----------------
 
-GLuint texture(const std::string& filename);
+void compute_terrain(vcl::mesh& terrain, perlin_noise_parameters const& parameters);
+void compute_terrain_berge_bas(vcl::mesh& terrain, perlin_noise_parameters const& parameters);
+void compute_terrain_berge_milieu(vcl::mesh& terrain, perlin_noise_parameters const& parameters);
+void compute_terrain_berge_haut(vcl::mesh& terrain, perlin_noise_parameters const& parameters);
+void compute_terrain_herbe(vcl::mesh& terrain, perlin_noise_parameters const& parameters);
+void compute_terrain_rive_droite(vcl::mesh& terrain, perlin_noise_parameters const& parameters);
+void compute_terrain_dune(vcl::mesh& terrain, perlin_noise_parameters const& parameters);
 
-//----------------generation des positions des elements sur le terrain-----------------
+//----------------texture du terrain (terrain_drawable.cpp)-----------------
 
-std::vector<vcl::vec3> generate_positions_forest(int N, vcl::mesh& terrain);
-std::vector<vcl::vec3> generate_positions_pyramids(vcl::mesh& terrain, perlin_noise_parameters const& parameters);
-std::vector<vcl::vec3> generate_positions_ferns(vcl::mesh& terrain, perlin_noise_parameters const& parameters);
-std::vector<vcl::vec3> generate_positions_columns(vcl::mesh& terrain, perlin_noise_parameters const& parameters);
-std::vector<vcl::vec3> generate_positions_columns2(vcl::mesh& terrain, perlin_noise_parameters const& parameters);
-std::vector<vcl::vec3> generate_positions_obelisque(vcl::mesh& terrain, perlin_noise_parameters const& parameters);
+GLuint texture(const std::string& filename);
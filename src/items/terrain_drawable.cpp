@@ -0,0 +1,18 @@
+#include "terrain.hpp"
+#include "../helpers/texture_registry.hpp"
+
+using namespace vcl;
+
+
+// partie OpenGL du terrain : les drawables sont crees dans main.cpp a partir du mesh calcule par compute_terrain
+
+// permet de plaquer une texture 2D sur un mesh drawable (ici le sable sur le terrain)
+GLuint texture(const std::string& filename)
+{
+    // Load an image dune from a file (shared with the other users of the same image), and get its identifier texture_image_id
+    GLuint const texture_image_id1 = texture_acquire(filename,
+        GL_MIRRORED_REPEAT /**GL_TEXTURE_WRAP_S*/,
+        GL_MIRRORED_REPEAT /**GL_TEXTURE_WRAP_T*/);
+    // Associate the texture_image_id to the image texture used when displaying visual
+    return texture_image_id1;
+}
@@ -1,4 +1,10 @@
 #include "vegetation.hpp"
+#include "../helpers/linear_arena.hpp"
+#include "../helpers/mesh_builder.hpp"
+#include "../helpers/mesh_cache.hpp"
+#include "../helpers/random.hpp"
+#include "../helpers/thread_pool.hpp"
+#include "../helpers/wind.hpp"
 
 
 using namespace vcl;
@@ -52,7 +58,6 @@ mesh create_palm_leaf(float width, float m, vec3 v_0, float t_max, unsigned int
     leaf.uv.resize(3 * N + 2);
     double dt = t_max / N;
     vec3 g = { 0.0f, 0.0f, -9.81f / m };
-    v_0.z += static_cast <float> (rand()) / (static_cast <float> (RAND_MAX / (3.14f / 4)));
     float norm = v_0.x * v_0.x + v_0.y * v_0.y + v_0.z * v_0.z;
     vec3 dir_width = { - v_0.y / norm, v_0.x / norm, 0.0f };
     double t = 0.0;
@@ -88,8 +93,10 @@ mesh create_palm_leaf(float width, float m, vec3 v_0, float t_max, unsigned int
 
 
 
-vcl::hierarchy_mesh_drawable create_palm_tree(float size, int N_leafs, float spreading)
+palm_tree_shape create_palm_tree_shape(float size, int N_leafs, float spreading, unsigned int seed)
 {
+    palm_tree_shape shape;
+
     float const h = size * 4.0f; // trunk height
     float const r = size * 4.0f / 20; // trunk radius
     float const width = size * 1.0f;
@@ -97,61 +104,44 @@ vcl::hierarchy_mesh_drawable create_palm_tree(float size, int N_leafs, float spr
     float const t_max = size * 5.0f / 3.0f;
 
     // Trunk
-    mesh trunk = create_tree_trunk_cylinder(r, h);
+    shape.trunk = create_tree_trunk_cylinder(r, h);
     //trunk.color.fill({ 0.4f, 0.3f, 0.3f });
 
     // Fruits
-    mesh fruits = mesh_primitive_ellipsoid({ size * 0.4f, size * 0.4f, size * 0.5f }, { 0.0f, 0.0f, h - size * 0.7f / 2 });
+    shape.fruits = mesh_primitive_ellipsoid({ size * 0.4f, size * 0.4f, size * 0.5f }, { 0.0f, 0.0f, h - size * 0.7f / 2 });
     //fruits.color.fill({ 1.0f, 1.0f, 0.0f });
 
-    // Foliage
-    float da = 2 * 3.14 / N_leafs;
-    mesh foliage = create_palm_leaf(width, m, { spreading, 0.0f, 1.0f }, t_max, 50);
-    for (int i = 1; i < N_leafs; i++) {
-        foliage.push_back(create_palm_leaf(width, m, { spreading * std::cos(i * da), spreading * std::sin(i * da), 1.0f }, t_max));
-    }
-    foliage.position += { 0.0f, 0.0f, h*1.01f }; // place foliage at the top of the trunk
+    // Foliage (the most expensive part, kept in the mesh cache)
+    // the seed of the shape is a key parameter (in two 16 bits halves, exact as floats), the global seed is the key seed
+    shape.foliage = cached_mesh("palm_foliage", { size, float(N_leafs), spreading, float(seed & 0xffffu), float(seed >> 16) }, rng_global_seed(), [&]() {
+        rng_stream rng = rng_create("palm_tree", seed);
+        float da = 2 * 3.14 / N_leafs;
+        vec3 const top = { 0.0f, 0.0f, h*1.01f }; // place foliage at the top of the trunk
+        // each leaf is randomly lifted so that they do not look alike
+        std::vector<mesh> parts;
+        parts.push_back(create_palm_leaf(width, m, { spreading, 0.0f, 1.0f + rng_uniform(rng, 0.0f, 3.14f / 4) }, t_max, 50));
+        for (int i = 1; i < N_leafs; i++) {
+            parts.push_back(create_palm_leaf(width, m, { spreading * std::cos(i * da), spreading * std::sin(i * da), 1.0f + rng_uniform(rng, 0.0f, 3.14f / 4) }, t_max));
+        }
+        size_t nb_vertices = 0, nb_triangles = 0;
+        for (mesh const& leaf : parts) {
+            nb_vertices += leaf.position.size();
+            nb_triangles += leaf.connectivity.size();
+        }
+        mesh_builder leaves;
+        leaves.reserve(nb_vertices, nb_triangles);
+        for (mesh const& leaf : parts)
+            leaves.append(leaf, top);
+        return leaves.finish();
+    });
     //foliage.color.fill({ 0.0f, 1.0f, 0.0f });
 
-    // Tree
-    hierarchy_mesh_drawable tree;
-    tree.add(mesh_drawable(trunk), "trunk");
-    tree.add(mesh_drawable(fruits), "fruits", "trunk");
-    tree.add(mesh_drawable(foliage), "foliage", "trunk");
-
-    return tree;
-}
-
-
-void initialize_palm_tree(vcl::hierarchy_mesh_drawable& palm_tree, float size)
-{
-    palm_tree = create_palm_tree(size, 20);
-    palm_tree["trunk"].transform.translate.x = 4.0f;
-    palm_tree.update_local_to_global_coordinates();
-
-    // Load an image from a file
-    image_raw const im_trunk = image_load_png("pictures/texture_trunk_palm_tree.png");
-    image_raw const im_leaf = image_load_png("pictures/texture_palm_leaf.png");
-    //image_raw const im_fruits = image_load_png("pictures/texture_palm_fruits.png");
-
-    // Send this image to the GPU, and get its identifier texture_image_id
-    GLuint const texture_image_id_trunk = opengl_texture_to_gpu(im_trunk,
-        GL_MIRRORED_REPEAT /*GL_CLAMP_TO_EDGE*/ /**GL_TEXTURE_WRAP_S*/,
-        GL_MIRRORED_REPEAT /*GL_CLAMP_TO_EDGE*/ /**GL_TEXTURE_WRAP_T*/);
-    GLuint const texture_image_id_leaf = opengl_texture_to_gpu(im_leaf,
-        GL_MIRRORED_REPEAT /*GL_CLAMP_TO_EDGE*/ /**GL_TEXTURE_WRAP_S*/,
-        GL_MIRRORED_REPEAT /*GL_CLAMP_TO_EDGE*/ /**GL_TEXTURE_WRAP_T*/);
-
-    // Associate the texture_image_id to the image texture used when displaying visual
-    palm_tree["trunk"].element.texture = texture_image_id_trunk;
-    palm_tree["foliage"].element.texture = texture_image_id_leaf;
-    palm_tree["fruits"].element.texture = texture_image_id_trunk;
+    // les feuilles plient d'autant plus qu'on s'eloigne du haut du tronc (anime par shader/mesh_wind.vert.glsl)
+    shape.foliage_wind = wind_weights(shape.foliage, { 0.0f, 0.0f, h * 1.01f }, 2.0f);
 
+    return shape;
 }
 
-
-
-
 vcl::mesh create_leaf(float radius, float width, int N)
 {
     mesh leaf;
@@ -208,49 +198,6 @@ void translate_leaf(vcl::mesh &leaf, vcl::vec3 p0)
 }
 
 
-void rule_leaf(std::vector<vcl::mesh>& list_leafs, float r, float w, std::vector<float> list_alphas)
-{
-    const int resolution = 50;
-    const int nb = 20; // number of leafs on each side of the former leaf
-    const int moy = nb / 2;
-    int s = list_leafs.size();
-    int N = list_leafs[0].position.size() / 2;
-    int pas = (N - 1) / nb;
-    vcl::vec3 p0;
-    for (int i = 0; i < s; i++) {
-        float alphaR = list_alphas[0] - 3.14f / 2;
-        float alphaL = list_alphas[0] + 3.14f / 2;
-        for (int j = 1; j < nb + 1; j++) {
-            p0 = (list_leafs[0].position[j * pas] + list_leafs[0].position[N + j * pas]) / 2;
-
-            // Right
-            mesh leaf = create_leaf(vcl::norm(list_leafs[0].position[j * pas] - p0), w, resolution);
-            rotate_leaf(leaf, alphaR);
-            translate_leaf(leaf, p0);
-            list_leafs.push_back(leaf);
-            list_alphas.push_back(alphaR);
-
-            // Left
-            leaf = create_leaf(vcl::norm(list_leafs[0].position[j * pas] - p0), w, resolution);
-            rotate_leaf(leaf, alphaL);
-            translate_leaf(leaf, p0);
-            list_leafs.push_back(leaf);
-            list_alphas.push_back(alphaL);
-        }
-
-        // Last leaf
-        /*mesh leaf = create_leaf(r, w, resolution);
-        rotate_leaf(leaf, list_alphas[0]);
-        translate_leaf(leaf, p0);
-        list_leafs.push_back(leaf);
-        list_alphas.push_back(list_alphas[0]);*/
-
-        list_leafs.erase(list_leafs.begin());
-        list_alphas.erase(list_alphas.begin());
-    }
-}
-
-
 void leaf_to_triangles(vcl::mesh& leaf)
 {
     int N = leaf.position.size() / 2;
@@ -264,73 +211,202 @@ void leaf_to_triangles(vcl::mesh& leaf)
 }
 
 
-void rule_trunk(std::vector<vcl::mesh> &list_trunks, std::vector<vcl::vec3> list_centers, float r, float h)
+// ---------------- generateur de fougere ----------------
+// Chaque feuille porte fern_sub_leafs sous-feuilles de chaque cote, chaque tronc est remplace par 7 troncs plus fins.
+// Le nombre de sommets et de triangles est connu a l'avance : le mesh est alloue une seule fois puis rempli,
+// les branches partant des feuilles principales etant developpees en parallele (en profondeur, les feuilles
+// intermediaires sont stockees dans une arene propre a chaque branche).
+
+namespace {
+
+int const fern_leaf_resolution = 50; // sommets sur chaque bord d'une feuille
+int const fern_sub_leafs = 20;       // sous-feuilles de chaque cote d'une feuille
+int const fern_sub_trunks = 7;       // troncs remplacant un tronc a chaque niveau
+
+struct fern_output
 {
-    int s = list_trunks.size();
-    for (int i = 0; i < s; i++) {
-        mesh trunk = create_tree_trunk_cylinder(r, h);
-        int p = trunk.position.size();
-        for (int k = 0; k < p; k++) {
-            trunk.position[k] += list_centers[0];
-        }
-        list_trunks.push_back(trunk);
-        list_centers.push_back(list_centers[0]);
-        for (int j = 0; j < 6; j++) {
-            mesh trunk = create_tree_trunk_cylinder(r, h);
-            vcl::vec3 center = list_centers[0] + vcl::vec3(2 * r * std::cos(1.047 * j), 2 * r * std::sin(1.047 * j), 0.0f);
-            int p = trunk.position.size();
-            for (int k = 0; k < p; k++) {
-                trunk.position[k] += center;
-            }
-            list_trunks.push_back(trunk);
-            list_centers.push_back(center);
-        }
-        list_trunks.erase(list_trunks.begin());
-        list_centers.erase(list_centers.begin());
+    vec3* position;
+    vec3* normal;
+    vec3* color;
+    vec2* uv;
+    uint3* connectivity;
+};
+
+// positions d'une feuille comme create_leaf, tournee de alpha autour de z puis dont le premier sommet est place en p0
+void fern_leaf_positions(float radius, float width, float alpha, vec3 const& p0, vec3* p)
+{
+    int const N = fern_leaf_resolution;
+    double const angle = std::acos(1 - width / (2 * radius));
+    double const beta = 2 * angle / N;
+    vec3 const first = { 0.0f, -radius * float(std::sin(angle)), 0.0f };
+    p[0] = first;
+    for (int k = 1; k < N; k++) {
+        float const x = radius * std::cos(-angle + k * beta);
+        float const y = radius * std::sin(-angle + k * beta);
+        p[k] = { width / 2 - radius + x, y, -k * k * radius / 50000 };
+        p[N + k] = { radius - width / 2 - x, y, -k * k * radius / 50000 };
+    }
+    p[N] = { 0.0f, radius * float(std::sin(angle)), -N * N * radius / 50000 };
+
+    float const c = std::cos(alpha), s = std::sin(alpha);
+    for (int k = 0; k < 2 * N; k++) {
+        vec3 const q = p[k] - first;
+        p[k] = vec3(c * q.x - s * q.y, s * q.x + c * q.y, q.z) + p0;
     }
 }
 
+// triangles (comme leaf_to_triangles), normales, couleur et uv d'une feuille finale
+void fern_finish_leaf(fern_output const& out, size_t leaf)
+{
+    int const N = fern_leaf_resolution;
+    unsigned int const o = unsigned(leaf * 2 * N);
+    uint3* t = out.connectivity + leaf * (2 * N - 2);
+    for (int i = 1; i < N - 1; i++) {
+        *t++ = uint3{ o + i, o + i + 1, o + N + i };
+        *t++ = uint3{ o + N + i, o + i + 1, o + N + i + 1 };
+    }
+    *t++ = uint3{ o, o + 1, o + N + 1 };
+    *t++ = uint3{ o + N - 1, o + N, o + 2 * N - 1 };
+
+    compute_normals(out.position, o, 2 * N, out.connectivity + leaf * (2 * N - 2), 2 * N - 2, out.normal);
+    for (int k = 0; k < 2 * N; k++) {
+        out.color[o + k] = { 0.0f, 1.0f, 0.0f };
+        out.uv[o + k] = { 0.0f, 0.0f };
+    }
+}
 
-vcl::mesh create_fern(float leaf_radius, float leaf_width, float trunk_radius, float trunk_height, int detail_level, int N_leafs)
+// developpe en profondeur une feuille de niveau level (positions dans parent) jusqu'au niveau detail_level
+void fern_expand_leaf(vec3 const* parent, float alpha, int level, int detail_level, float leaf_width, vec3* const* scratch, fern_output const& out, size_t& next_leaf)
 {
-    const unsigned int N = 50;
-    std::vector<vcl::mesh> list_leafs, list_trunks;
-    std::vector<vcl::vec3> list_centers;
-    std::vector<float> list_alphas;
-    list_trunks.push_back(create_tree_trunk_cylinder(trunk_radius, trunk_height));
-    list_centers.push_back(vec3(0.0f, 0.0f, 0.0f));
-    for (int l = 0; l < N_leafs; l++) {
-        list_leafs.push_back(create_leaf(leaf_radius, leaf_width, N));
-        translate_leaf(list_leafs[l], { 0.0f, 0.0f, trunk_height - 0.01f });
-        rotate_leaf(list_leafs[l], static_cast <float> (rand()) / (static_cast <float> (RAND_MAX / (3.14f / 4))), 0);
-        float alpha = 2 * l * 3.14f / N_leafs;
-        rotate_leaf(list_leafs[l], alpha);
-        list_alphas.push_back(alpha);
+    int const N = fern_leaf_resolution;
+    int const pas = (N - 1) / fern_sub_leafs;
+    float const width = leaf_width / std::pow(5.0f, float(level + 1));
+    for (int j = 1; j < fern_sub_leafs + 1; j++) {
+        vec3 const p0 = (parent[j * pas] + parent[N + j * pas]) / 2;
+        float const radius = norm(parent[j * pas] - p0);
+        float const sides[2] = { alpha - 3.14f / 2, alpha + 3.14f / 2 }; // droite puis gauche
+        for (float const side : sides) {
+            if (level + 1 == detail_level) {
+                fern_leaf_positions(radius, width, side, p0, out.position + next_leaf * 2 * N);
+                fern_finish_leaf(out, next_leaf++);
+            }
+            else {
+                fern_leaf_positions(radius, width, side, p0, scratch[level + 1]);
+                fern_expand_leaf(scratch[level + 1], side, level + 1, detail_level, leaf_width, scratch, out, next_leaf);
+            }
+        }
     }
-    for (int i = 0; i < detail_level; i++) {
-        trunk_radius /= 3;
-        leaf_radius /= 5;
-        leaf_width /= 5;
-        rule_leaf(list_leafs, leaf_radius, leaf_width, list_alphas);
-        rule_trunk(list_trunks, list_centers, trunk_radius, trunk_height);  
+}
+
+// centres des troncs du niveau level autour du centre c, dans l'ordre de generation
+void expand_trunk_centers(vec3 const& c, float radius, int level, int detail_level, std::vector<vec3>& centers)
+{
+    if (level == detail_level) {
+        centers.push_back(c);
+        return;
     }
+    float const r = radius / 3;
+    expand_trunk_centers(c, r, level + 1, detail_level, centers);
+    for (int j = 0; j < fern_sub_trunks - 1; j++)
+        expand_trunk_centers(c + vec3(2 * r * std::cos(1.047 * j), 2 * r * std::sin(1.047 * j), 0.0f), r, level + 1, detail_level, centers);
+}
+
+}
+
+
+// chaque tronc est remplace par un tronc 3 fois plus fin et 6 autres autour de lui, detail_level fois
+std::vector<vcl::vec3> create_trunk_centers(float radius, int detail_level)
+{
+    std::vector<vec3> centers;
+    expand_trunk_centers({ 0.0f, 0.0f, 0.0f }, radius, 0, detail_level, centers);
+    return centers;
+}
+
+
+vcl::mesh create_fern(float leaf_radius, float leaf_width, float trunk_radius, float trunk_height, int detail_level, int N_leafs, unsigned int seed)
+{
+    int const N = fern_leaf_resolution;
+
+    // feuilles principales : inclinaison aleatoire, reparties autour du tronc
+    rng_stream rng = rng_create("fern", seed);
+    std::vector<float> tilt(N_leafs);
+    for (int l = 0; l < N_leafs; l++)
+        tilt[l] = rng_uniform(rng, 0.0f, 3.14f / 4);
+
+    // troncs : un seul mesh de reference, recopie a chaque centre
+    std::vector<vec3> const centers = create_trunk_centers(trunk_radius, detail_level);
+    mesh const trunk = create_tree_trunk_cylinder(trunk_radius / std::pow(3.0f, float(detail_level)), trunk_height);
+
+    // taille exacte du resultat
+    size_t leafs_per_branch = 1;
+    for (int i = 0; i < detail_level; i++)
+        leafs_per_branch *= 2 * fern_sub_leafs;
+    size_t const nb_leafs = leafs_per_branch * N_leafs;
+    size_t const leaf_vertices = nb_leafs * 2 * N;
+    size_t const nb_vertices = leaf_vertices + centers.size() * trunk.position.size();
+    size_t const nb_triangles = nb_leafs * (2 * N - 2) + centers.size() * trunk.connectivity.size();
+
     vcl::mesh fern;
-    for (auto leaf : list_leafs) {
-        leaf_to_triangles(leaf);
-        leaf.color.fill({ 0.0f, 1.0f, 0.0f });
-        fern.push_back(leaf);
-    }
-    for (auto trunk : list_trunks) {
-        trunk.color.fill({ 196.0 / 255, 128.0 / 255, 77.0 / 255 });
-        fern.push_back(trunk);
+    fern.position.resize(nb_vertices);
+    fern.normal.resize(nb_vertices);
+    fern.color.resize(nb_vertices);
+    fern.uv.resize(nb_vertices);
+    fern.connectivity.resize(nb_triangles);
+    fern_output const out = { ptr(fern.position), ptr(fern.normal), ptr(fern.color), ptr(fern.uv), ptr(fern.connectivity) };
+
+    // chaque branche remplit sa propre tranche du mesh
+    parallel_for(default_thread_pool(), size_t(N_leafs), [&](size_t l) {
+        float const c = std::cos(tilt[l]), s = std::sin(tilt[l]);
+        float const alpha = 2 * l * 3.14f / N_leafs;
+        size_t next_leaf = l * leafs_per_branch;
+
+        // feuille principale : placee en haut du tronc, inclinee autour de x, puis tournee de alpha autour de z
+        linear_arena arena((detail_level + 1) * 2 * N * sizeof(vec3) + 64);
+        vec3* top = detail_level == 0 ? out.position + next_leaf * 2 * N : arena.allocate<vec3>(2 * N);
+        fern_leaf_positions(leaf_radius, leaf_width, 0.0f, { 0.0f, 0.0f, trunk_height - 0.01f }, top);
+        float const ca = std::cos(alpha), sa = std::sin(alpha);
+        for (int k = 0; k < 2 * N; k++) {
+            vec3 const q = { top[k].x, c * top[k].y - s * top[k].z, s * top[k].y + c * top[k].z };
+            top[k] = { ca * q.x - sa * q.y, sa * q.x + ca * q.y, q.z };
+        }
+
+        if (detail_level == 0) {
+            fern_finish_leaf(out, next_leaf);
+            return;
+        }
+        std::vector<vec3*> scratch(detail_level + 1, nullptr);
+        for (int level = 1; level < detail_level; level++)
+            scratch[level] = arena.allocate<vec3>(2 * N);
+        fern_expand_leaf(top, alpha, 0, detail_level, leaf_width, scratch.data(), out, next_leaf);
+    });
+
+    vec3 const trunk_color = { 196.0f / 255, 128.0f / 255, 77.0f / 255 };
+    size_t v = leaf_vertices, t = nb_leafs * (2 * N - 2);
+    for (vec3 const& center : centers) {
+        unsigned int const offset = unsigned(v);
+        for (size_t k = 0; k < trunk.position.size(); k++, v++) {
+            out.position[v] = trunk.position[k] + center;
+            out.normal[v] = trunk.normal[k];
+            out.color[v] = trunk_color;
+            out.uv[v] = trunk.uv[k];
+        }
+        for (size_t k = 0; k < trunk.connectivity.size(); k++, t++)
+            out.connectivity[t] = uint3{ trunk.connectivity[k][0] + offset, trunk.connectivity[k][1] + offset, trunk.connectivity[k][2] + offset };
     }
-    fern.fill_empty_field();
     return fern;
 }
 
 
-void initialize_fern(vcl::mesh_drawable& fern, float size)
+vcl::mesh create_fern_shape(float size)
 {
-    fern = mesh_drawable(create_fern(size * 1.0f, size * 0.3f, size * 0.1f, size * 0.03f, 2));
-    fern.transform.translate.z = 0.4f;
+    return cached_mesh("fern", { size, 2.0f }, rng_global_seed(), [size]() {
+        return create_fern(size * 1.0f, size * 0.3f, size * 0.1f, size * 0.03f, 2);
+    });
 }
+
+// poids du vent de la fougere : les feuilles bougent d'autant plus qu'elles s'eloignent de l'axe
+std::vector<float> create_fern_wind(vcl::mesh const& shape)
+{
+    return wind_weights(shape, { 0.0f, 0.0f, 0.0f }, 1.5f, true);
+}
+
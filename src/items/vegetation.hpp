@@ -4,14 +4,26 @@
 
 vcl::mesh create_tree_trunk_cylinder(float radius, float height);
 vcl::mesh create_palm_leaf(float width = 2.0f, float m = 5.0f, vcl::vec3 v_0 = { 1.0f, 1.0f, 1.0f }, float t_max = 2.0f, unsigned int N = 100, float coef_end = 3.0f);
-vcl::hierarchy_mesh_drawable create_palm_tree(float size, int N_leafs=10, float spreading=1.2f);
-void initialize_palm_tree(vcl::hierarchy_mesh_drawable& palm_tree, float size);
+
+// meshes of the palm tree, computed on the CPU before being sent to the GPU
+struct palm_tree_shape
+{
+    vcl::mesh trunk;
+    vcl::mesh fruits;
+    vcl::mesh foliage;
+    std::vector<float> foliage_wind; // poids du vent de chaque sommet du feuillage (0 en haut du tronc, 1 au bout des feuilles)
+};
+palm_tree_shape create_palm_tree_shape(float size, int N_leafs=10, float spreading=1.2f, unsigned int seed=0);
+vcl::hierarchy_mesh_drawable create_palm_tree(palm_tree_shape const& shape);
+vcl::hierarchy_mesh_drawable create_palm_tree(float size, int N_leafs=10, float spreading=1.2f, unsigned int seed=0);
+void initialize_palm_tree(vcl::hierarchy_mesh_drawable& palm_tree, palm_tree_shape const& shape, GLuint shader_wind = 0);
 
 vcl::mesh create_leaf(float radius, float width, int N);
 void rotate_leaf(vcl::mesh &leaf, float alpha, int axis=2);
 void translate_leaf(vcl::mesh& leaf, vcl::vec3 p0);
-void rule_leaf(std::vector<vcl::mesh>& list_leafs, float r, float w, std::vector<float> list_alphas);
-void rule_trunk(std::vector<vcl::mesh>& list_trunks, std::vector<vcl::vec3> list_centers, float r, float h);
 void leaf_to_triangles(vcl::mesh &leaf);
-vcl::mesh create_fern(float length, float max_width, float radius, float height, int detail_level, int N_leafs = 10);
-void initialize_fern(vcl::mesh_drawable& fern, float size);
+std::vector<vcl::vec3> create_trunk_centers(float radius, int detail_level);
+vcl::mesh create_fern(float length, float max_width, float radius, float height, int detail_level, int N_leafs = 10, unsigned int seed = 0);
+vcl::mesh create_fern_shape(float size);
+std::vector<float> create_fern_wind(vcl::mesh const& shape);
+void initialize_fern(vcl::mesh_drawable& fern, vcl::mesh const& shape, std::vector<float> const& wind = {}, GLuint shader_wind = 0);
@@ -0,0 +1,62 @@
+#include "vegetation.hpp"
+#include "../helpers/texture_registry.hpp"
+#include "../helpers/wind.hpp"
+
+using namespace vcl;
+
+
+// partie OpenGL de la vegetation : les formes sont calculees par vegetation.cpp
+
+vcl::hierarchy_mesh_drawable create_palm_tree(palm_tree_shape const& shape)
+{
+    // Tree
+    hierarchy_mesh_drawable tree;
+    tree.add(mesh_drawable(shape.trunk), "trunk");
+    tree.add(mesh_drawable(shape.fruits), "fruits", "trunk");
+    tree.add(mesh_drawable(shape.foliage), "foliage", "trunk");
+
+    return tree;
+}
+
+vcl::hierarchy_mesh_drawable create_palm_tree(float size, int N_leafs, float spreading, unsigned int seed)
+{
+    return create_palm_tree(create_palm_tree_shape(size, N_leafs, spreading, seed));
+}
+
+void initialize_palm_tree(vcl::hierarchy_mesh_drawable& palm_tree, palm_tree_shape const& shape, GLuint shader_wind)
+{
+    palm_tree = create_palm_tree(shape);
+    palm_tree["trunk"].transform.translate.x = 4.0f;
+    palm_tree.update_local_to_global_coordinates();
+
+    // Load the images from files (shared with the other users of the same images), and get their identifiers texture_image_id
+    GLuint const texture_image_id_trunk = texture_acquire("pictures/texture_trunk_palm_tree.png",
+        GL_MIRRORED_REPEAT /*GL_CLAMP_TO_EDGE*/ /**GL_TEXTURE_WRAP_S*/,
+        GL_MIRRORED_REPEAT /*GL_CLAMP_TO_EDGE*/ /**GL_TEXTURE_WRAP_T*/);
+    GLuint const texture_image_id_leaf = texture_acquire("pictures/texture_palm_leaf.png",
+        GL_MIRRORED_REPEAT /*GL_CLAMP_TO_EDGE*/ /**GL_TEXTURE_WRAP_S*/,
+        GL_MIRRORED_REPEAT /*GL_CLAMP_TO_EDGE*/ /**GL_TEXTURE_WRAP_T*/);
+
+    // Associate the texture_image_id to the image texture used when displaying visual
+    palm_tree["trunk"].element.texture = texture_image_id_trunk;
+    palm_tree["foliage"].element.texture = texture_image_id_leaf;
+    palm_tree["fruits"].element.texture = texture_acquire("pictures/texture_trunk_palm_tree.png",
+        GL_MIRRORED_REPEAT, GL_MIRRORED_REPEAT);
+
+    // feuillage anime par le vent, sans envoi de donnees a chaque image
+    if (shader_wind != 0 && shape.foliage_wind.size() == shape.foliage.position.size()) {
+        attach_wind_weights(palm_tree["foliage"].element, shape.foliage_wind);
+        palm_tree["foliage"].element.shader = shader_wind;
+    }
+
+}
+
+void initialize_fern(vcl::mesh_drawable& fern, vcl::mesh const& shape, std::vector<float> const& wind, GLuint shader_wind)
+{
+    fern = mesh_drawable(shape);
+    fern.transform.translate.z = 0.4f;
+    if (shader_wind != 0 && wind.size() == shape.position.size()) {
+        attach_wind_weights(fern, wind);
+        fern.shader = shader_wind;
+    }
+}
@@ -0,0 +1,30 @@
+#include "water.hpp"
+
+using namespace vcl;
+
+
+mesh create_water(unsigned int N, perlin_noise_parameters const& parameters)
+{
+    // meme domaine et memes hauteurs que le terrain, a la resolution de l'eau
+    mesh water = create_terrain(N);
+    compute_terrain(water, parameters);
+
+    // seuls les triangles ayant au moins un sommet dans l'eau sont dessines
+    buffer<uint3> connectivity;
+    for (uint3 const& triangle : water.connectivity) {
+        if (is_water(water.position[triangle[0]].x, water.position[triangle[0]].y)
+                || is_water(water.position[triangle[1]].x, water.position[triangle[1]].y)
+                || is_water(water.position[triangle[2]].x, water.position[triangle[2]].y))
+            connectivity.push_back(triangle);
+    }
+    water.connectivity = connectivity;
+    return water;
+}
+
+std::vector<float> water_weights(mesh const& water)
+{
+    std::vector<float> weights(water.position.size());
+    for (size_t k = 0; k < weights.size(); k++)
+        weights[k] = is_water(water.position[k].x, water.position[k].y) ? 1.0f : 0.0f;
+    return weights;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "vcl/vcl.hpp"
+#include "terrain.hpp"
+#include <vector>
+
+//----------------surface du fleuve, animee entierement dans shader/water.vert.glsl-----------------
+// - maillage a sa propre resolution, independante de celle du terrain : seuls les triangles touchant l'eau sont gardes
+// - chaque sommet a un poids (1 dans l'eau, 0 sur la rive) calcule une fois avec le maillage
+// - hauteur des vagues et normale evaluees par le shader (bruit et ses derivees), par frame seuls le temps
+//   et la hauteur sont envoyes : le VBO de l'eau reste statique
+
+// maillage N x N de l'eau, les sommets de la rive sont a la hauteur du terrain
+vcl::mesh create_water(unsigned int N, perlin_noise_parameters const& parameters);
+// 1 pour les sommets dans l'eau, 0 pour ceux de la rive
+std::vector<float> water_weights(vcl::mesh const& water);
+
+// partie OpenGL (water_drawable.cpp)
+
+// envoie les poids une fois et les attache au vao du drawable (attribut a la location 6)
+void attach_water_weights(vcl::mesh_drawable& drawable, std::vector<float> const& weights);
+// uniforms du shader de l'eau, a chaque frame
+void water_set_uniforms(GLuint shader, perlin_noise_parameters const& parameters, float t, float tmax);
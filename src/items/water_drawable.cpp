@@ -0,0 +1,33 @@
+#include "water.hpp"
+
+using namespace vcl;
+
+
+// partie OpenGL de l'eau : le maillage ne change plus apres son envoi, les vagues sont calculees par le shader
+
+void attach_water_weights(mesh_drawable& drawable, std::vector<float> const& weights)
+{
+    GLuint vbo = 0;
+    glGenBuffers(1, &vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(weights.size() * sizeof(float)), weights.data(), GL_STATIC_DRAW);
+
+    glBindVertexArray(drawable.vao);
+    glEnableVertexAttribArray(6);
+    glVertexAttribPointer(6, 1, GL_FLOAT, GL_FALSE, 0, nullptr);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    drawable.vbo["water"] = vbo;
+}
+
+void water_set_uniforms(GLuint shader, perlin_noise_parameters const& parameters, float t, float tmax)
+{
+    if (shader == 0)
+        return;
+    glUseProgram(shader);
+    glUniform1f(glGetUniformLocation(shader, "water_time"), t);
+    glUniform1f(glGetUniformLocation(shader, "water_period"), tmax);
+    glUniform1f(glGetUniformLocation(shader, "water_height"), parameters.terrain_height * 0.2f);
+    glUseProgram(0);
+}
@@ -1,5 +1,9 @@
 #include "vcl/vcl.hpp"
 #include <iostream>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+#include <cstdio>
 
 #include "helpers/scene_helper.hpp"
 #include "items/terrain.hpp"
@@ -9,7 +13,29 @@
 #include "items/bird.hpp"
 #include "items/boat.hpp"
 #include "items/corde.hpp"
+#include "items/fleet.hpp"
+#include "items/scatter.hpp"
+#include "items/grass.hpp"
+#include "items/simulation.hpp"
+#include "items/water.hpp"
 #include "helpers/environment_map.hpp"
+#include "helpers/random.hpp"
+#include "helpers/texture_loader.hpp"
+#include "helpers/texture_registry.hpp"
+#include "helpers/texture_bake.hpp"
+#include "helpers/shader_cache.hpp"
+#include "helpers/mesh_builder.hpp"
+#include "helpers/scene_file.hpp"
+#include "helpers/task_graph.hpp"
+#include "helpers/thread_pool.hpp"
+#include "helpers/job_benchmark.hpp"
+#include "helpers/wind.hpp"
+#include "helpers/entity_store.hpp"
+#include "helpers/frame_pipeline.hpp"
+#include "helpers/linear_arena.hpp"
+#include "helpers/allocation_counter.hpp"
+#include "helpers/line_batch.hpp"
+#include "helpers/stream_buffer.hpp"
 
 
 using namespace vcl;
@@ -24,9 +50,11 @@ void mouse_move_callback(GLFWwindow* window, double xpos, double ypos);
 void window_size_callback(GLFWwindow* window, int width, int height);
 
 
+struct render_snapshot;
 void initialize_data();
-void display_interface();
-void display_frame();
+void simulate_frame(render_snapshot& frame);
+void display_interface(render_snapshot const& frame);
+void display_frame(render_snapshot const& frame);
 
 timer_interval timer;
 
@@ -39,53 +67,118 @@ mesh_drawable terrain_berge_bas;
 mesh_drawable terrain_herbe;
 mesh_drawable terrain_dune;
 
-float t = 0;
+// river surface, its waves are computed in shader/water.vert.glsl
+GLuint shader_water = 0;
+unsigned int water_resolution = 200;    // independent of the terrain grid
 
 // skybox
 mesh_drawable cube_map;
 
-// mesh_drawables of displayed objects
-mesh_drawable pyramid;
-hierarchy_mesh_drawable palm_tree;
-mesh_drawable column;
-mesh_drawable obelisque;
-hierarchy_mesh_drawable bird;
-mesh_drawable boat;
-mesh_drawable boat_drift;
-mesh_drawable fern;
-
-// rope initialisation
-vcl::buffer<vcl::vec3> particules;
-vcl::buffer<vcl::vec3> vitesses;
-vcl::buffer<float> L0_array;
-vcl::buffer<float> raideurs;
-vec3 pos_poteau;
+// drawables shared by the entities of the scene, referenced by index from their mesh component
+enum scene_drawable { drawable_pyramid, drawable_column, drawable_obelisque, drawable_fern, drawable_boat, drawable_count };
+enum scene_hierarchy { hierarchy_palm_tree, hierarchy_bird, hierarchy_count };
+mesh_drawable drawables[drawable_count];
+hierarchy_mesh_drawable hierarchies[hierarchy_count];
+char const* const hierarchy_root[hierarchy_count] = { "trunk", "body" }; // node moved by the transform of the entity
+
+// entities of the scene: props, birds, drifting boat, moored boat and its rope
+entity_store world;
+
+// birds, boats, fleet and rope (the same systems run without window in nile_sim)
+nile_simulation sim;
+int const nb_agents_fleet[fleet_kind_count] = { 600, 300, 100 };
+
+// boats following the river splines, drawn instanced
+fleet_drawable boats_fleet_visual;
+
 mesh_drawable sphere;
-segments_drawable segments;
 
-// bird initialisation
-vcl::buffer<vec3> key_positions_bird;
-vcl::buffer<float> key_times_bird;
-vcl::buffer<vec3> follower_birds;
-vcl::buffer<vec3> speeds_birds;
-const int nb_follower_birds = 10;
+// lines of the frame (rope, trajectories, debug frame) drawn with a single call
+line_batch lines;
+
+// vertex data rewritten every frame (fleet transforms, lines), in a ring of fenced regions
+stream_buffer dynamic_vertices;
+
+// props placed on the terrain, read from the scene file
+std::string scene_filename = "scene/nile.scene";
+scene_description layout;
+
+// wind swaying the foliage in shader/mesh_wind.vert.glsl
+GLuint shader_mesh_wind = 0;
+float wind_strength = 0.03f;
+float wind_angle = 0.5f;
 
-// positions on terrain to display objects
-std::vector<vec3> pos_forest;
-std::vector<vec3> pos_ferns;
-std::vector<vec3> pos_pyramids;
-std::vector<vec3> pos_columns;
-std::vector<vec3> pos_obelisques;
+// grass blades on the herbe region, drawn instanced tile by tile
+grass_field grass;
+grass_drawable grass_visual;
+GLuint shader_grass = 0;
+int grass_budget = 500000;
 
-// random rotations so that the trees do not look alike
-vcl::buffer<float> rotation_palm_tree;
+// Simulation and rendering run on two threads
+//  - the simulation thread owns the timer, the entity transforms and velocities, the terrain mesh, the fleet and the rope
+//  - this thread owns the OpenGL context: it draws from the snapshot of the frame and never reads the simulated state
+struct render_snapshot
+{
+    float t = 0.0f;
+    float dt = 0.0f;
+    float t_min = 0.0f;
+    float t_max = 0.0f;
+
+    // transforms of the entities, indexed like world
+    std::vector<vec3> position;
+    std::vector<float> angle;
+
+    vcl::buffer<vec3> rope;
+    fleet boats;    // only the positions, headings and ranges of kinds are filled
+    float fleet_agents_per_ms = 0.0f;
+
+    allocation_statistics simulation_allocations;  // heap allocations of the step
+};
+frame_pipeline<render_snapshot> pipeline;
+allocation_statistics render_frame_allocations; // of the last frame drawn
+
+// requests of the interface to the simulation thread, read at the beginning of each step
+struct simulation_controls
+{
+    float time_scale = 1.0f;
+    float seek_time = -1.0f;    // moves the timer when >= 0
+};
+std::mutex controls_mutex;
+simulation_controls controls;
 
 
 
-int main(int, char* argv[])
+int main(int argc, char* argv[])
 {
+	auto const start_time = std::chrono::steady_clock::now();
 	std::cout << "Run " << argv[0] << std::endl;
 
+	// the same seed gives the same scene and the same animation
+	// --sync-textures waits for all the textures before the first frame (previous behavior)
+	bool sync_textures = false;
+	for (int k = 1; k < argc; k++) {
+		std::string const arg = argv[k];
+		if (arg == "--seed" && k + 1 < argc)
+			rng_set_global_seed(std::strtoull(argv[k + 1], nullptr, 10));
+		if (arg == "--sync-textures")
+			sync_textures = true;
+		if (arg == "--scene" && k + 1 < argc)
+			scene_filename = argv[k + 1];
+		if (arg == "--pbo")
+			texture_loader_use_pbo(true);
+		if (arg == "--bake") {
+			// offline step: convert pictures/ into mipmapped containers, then quit
+			bake_pictures("pictures/");
+			return 0;
+		}
+		if (arg == "--bench-jobs") {
+			// scheduling overhead of the job system on fine-grained tasks, then quit
+			run_job_benchmark(default_thread_pool(), std::cout);
+			return 0;
+		}
+	}
+	std::cout << "Seed " << rng_global_seed() << std::endl;
+
     int const width = 1280, height = 1024;
 	GLFWwindow* window = create_window(width, height);
 	window_size_callback(window, width, height);
@@ -98,12 +191,31 @@ int main(int, char* argv[])
 
 	std::cout << "Initialize data ..." << std::endl;
 	initialize_data();
+	if (sync_textures)
+		texture_loader_finish();
 
 	std::cout << "Start animation loop ..." << std::endl;
+	pipeline.start(simulate_frame);
 	user.fps_record.start();
 	glEnable(GL_DEPTH_TEST);
+	bool first_frame = true;
+	bool textures_loaded = false;
 	while (!glfwWindowShouldClose(window))
 	{
+		// transient data of the frame goes to the frame arena, the counter checks that a frame does not allocate
+		frame_arena().reset();
+		allocation_statistics const frame_start_allocations = thread_allocations();
+
+		// state simulated while the previous frame was submitted
+		render_snapshot const& frame = pipeline.acquire();
+
+		// textures decoded by the worker threads are sent to the GPU a few at a time
+		texture_loader_upload_pending();
+		if (!textures_loaded && texture_loader_remaining() == 0) {
+			textures_loaded = true;
+			std::cout << "All textures loaded after " << std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start_time).count() << " ms" << std::endl;
+		}
+
         scene.light = scene.camera.position();
         //scene.light = scene.camera_head.position();
 		user.fps_record.update();
@@ -113,25 +225,37 @@ int main(int, char* argv[])
 		glClear(GL_DEPTH_BUFFER_BIT);
 		imgui_create_frame();
 		if (user.fps_record.event) {
-			std::string const title = "VCL Display - " + str(user.fps_record.fps) + " fps";
-			glfwSetWindowTitle(window, title.c_str());
+			size_t const title_size = 64;
+			char* const title = frame_arena().allocate<char>(title_size);
+			std::snprintf(title, title_size, "VCL Display - %d fps", int(user.fps_record.fps));
+			glfwSetWindowTitle(window, title);
+			shader_cache_hot_reload();  // edited .glsl files are reloaded about once per second
 		}
 
         ImGui::Begin("GUI",NULL,ImGuiWindowFlags_AlwaysAutoResize);
         user.cursor_on_gui = ImGui::GetIO().WantCaptureMouse;
 
-        //if (user.gui.display_frame) draw(user.global_frame, scene);
-
-		display_interface();
-		display_frame();
+		display_interface(frame);
+		begin_stream_frame(dynamic_vertices);
+		display_frame(frame);
+		end_stream_frame(dynamic_vertices);
 
 
 		ImGui::End();
 		imgui_render_frame(window);
 		glfwSwapBuffers(window);
 		glfwPollEvents();
+
+		render_frame_allocations = thread_allocations() - frame_start_allocations;
+
+		if (first_frame) {
+			first_frame = false;
+			std::cout << "Time to first frame: " << std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start_time).count() << " ms" << std::endl;
+		}
 	}
 
+	pipeline.stop();
+	texture_registry_release_all();
 	imgui_cleanup();
 	glfwDestroyWindow(window);
 	glfwTerminate();
@@ -143,120 +267,262 @@ int main(int, char* argv[])
 
 void initialize_data()
 {
-	// Basic setups of shaders and camera
-	GLuint const shader_mesh = opengl_create_shader_program(opengl_shader_preset("mesh_vertex"), opengl_shader_preset("mesh_fragment"));
-    GLuint const shader_uniform_color = opengl_create_shader_program(opengl_shader_preset("single_color_vertex"), opengl_shader_preset("single_color_fragment"));
-    GLuint const texture_white = opengl_texture_to_gpu(image_raw{ 1,1,image_color_type::rgba,{255,255,255,255} });
-	mesh_drawable::default_shader = shader_mesh;
-	mesh_drawable::default_texture = opengl_texture_to_gpu(image_raw{ 1,1,image_color_type::rgba,{255,255,255,255} });
-    curve_drawable::default_shader = shader_uniform_color;
-    segments_drawable::default_shader = shader_uniform_color;
-
-	user.global_frame = mesh_drawable(mesh_primitive_frame());
-    user.gui.display_frame = false;
-
-    // camera normal
-    scene.camera.distance_to_center = 2.5f;
-    scene.camera.look_at({ -0.5f,2.5f,1 }, { 0,0,0 }, { 0,0,1 });
-
-
-    // camera fly_mode
-    /*scene.camera_head.position_camera = {0.0f, -15.0f, 2.0f};
-    scene.camera_head.manipulator_rotate_roll_pitch_yaw(-pi/2.0f,pi/2.0f,pi/2.0f);*/
-
-    perlin_noise_parameters parameters = get_noise_params();
-
-    // For the rope
-    segments = segments_drawable({ {0,0,0},{1,0,0} });
-
-    // Create skybox
-    // Read shaders
-    GLuint const shader_skybox = opengl_create_shader_program(read_text_file("shader/skybox.vert.glsl"), read_text_file("shader/skybox.frag.glsl"));
-    GLuint const shader_environment_map = opengl_create_shader_program(read_text_file("shader/environment_map.vert.glsl"), read_text_file("shader/environment_map.frag.glsl"));
-    
-    // Read cubemap texture
-    GLuint texture_cubemap = cubemap_texture("pictures/skybox_sky/");
-
-    // Cube used to display the skybox
-    mesh cube = mesh_primitive_cube({0,0,0},2.0f);
-    cube_map = mesh_drawable( cube, shader_skybox, texture_cubemap);
+    // Initialization is a graph of tasks: the CPU-only work (meshes, placements) runs on the worker threads,
+    // everything touching the OpenGL context runs in sequence on this thread
+    task_graph startup;
+    perlin_noise_parameters const parameters = get_noise_params();
+
+    // shapes computed by the workers before being sent to the GPU
+    mesh pyramid_shape, column_shape, obelisque_shape, boat_shape, fern_shape, water_shape;
+    std::vector<float> fern_wind, water_weight;
+    palm_tree_shape palm_shape;
+    mesh fleet_shapes[fleet_kind_count];
+    GLuint shader_skybox = 0, shader_mesh_instanced = 0;
+    GLuint texture_cubemap = 0;
+
+	int const shaders = startup.add("shaders", task_main, [&]() {
+		// Basic setups of shaders and camera
+		// (the linked programs are cached on disk, see shader_cache.hpp)
+		GLuint const shader_mesh = shader_cache_program(shader_preset("mesh_vertex"), shader_preset("mesh_fragment"));
+		GLuint const shader_uniform_color = shader_cache_program(shader_preset("single_color_vertex"), shader_preset("single_color_fragment"));
+		GLuint const texture_white = opengl_texture_to_gpu(image_raw{ 1,1,image_color_type::rgba,{255,255,255,255} });
+		mesh_drawable::default_shader = shader_mesh;
+		mesh_drawable::default_texture = opengl_texture_to_gpu(image_raw{ 1,1,image_color_type::rgba,{255,255,255,255} });
+		curve_drawable::default_shader = shader_uniform_color;
+		segments_drawable::default_shader = shader_uniform_color;
+
+		shader_skybox = shader_cache_program(shader_file("shader/skybox.vert.glsl"), shader_file("shader/skybox.frag.glsl"));
+		shader_water = shader_cache_program(shader_file("shader/water.vert.glsl"), shader_file("shader/environment_map.frag.glsl"));
+		shader_mesh_instanced = shader_cache_program(shader_file("shader/mesh_instanced.vert.glsl"), shader_preset("mesh_fragment"));
+		shader_mesh_wind = shader_cache_program(shader_file("shader/mesh_wind.vert.glsl"), shader_preset("mesh_fragment"));
+		shader_grass = shader_cache_program(shader_file("shader/grass.vert.glsl"), shader_preset("mesh_fragment"));
+
+		user.global_frame = mesh_drawable(mesh_primitive_frame());
+		user.gui.display_frame = false;
+
+		// camera normal
+		scene.camera.distance_to_center = 2.5f;
+		scene.camera.look_at({ -0.5f,2.5f,1 }, { 0,0,0 }, { 0,0,1 });
+
+		// camera fly_mode
+		/*scene.camera_head.position_camera = {0.0f, -15.0f, 2.0f};
+		scene.camera_head.manipulator_rotate_roll_pitch_yaw(-pi/2.0f,pi/2.0f,pi/2.0f);*/
+
+		// For the rope and the debug lines
+		initialize_line_batch(lines, shader_cache_program(shader_file("shader/lines.vert.glsl"), shader_file("shader/lines.frag.glsl")));
+		initialize_stream_buffer(dynamic_vertices, size_t(4) << 20);
+		user.gui.display_trajectory = false;
+	});
+
+    // Create skybox (the images are decoded by the texture loader threads)
+    int const skybox = startup.add("skybox", task_main, [&]() {
+        texture_cubemap = cubemap_acquire("pictures/skybox_sky/");
+        mesh cube = mesh_primitive_cube({0,0,0},2.0f);
+        cube_map = mesh_drawable( cube, shader_skybox, texture_cubemap);
+    }, { shaders });
 
     // Create the terrain
-    terrain = create_terrain();
-    terrain_herbe = mesh_drawable(terrain);
-    terrain_water = mesh_drawable(terrain, shader_environment_map, texture_cubemap);
-    terrain_berge_bas = mesh_drawable(terrain);
-    terrain_berge_milieu = mesh_drawable(terrain);
-    terrain_berge_haut = mesh_drawable(terrain);
-    terrain_dune = mesh_drawable(terrain);
-    update_terrain(terrain,terrain_herbe,terrain_berge_bas, terrain_berge_milieu, terrain_berge_haut,terrain_dune,terrain_water, parameters, t, timer.t_max);
-
-    // Texture Images load and association
-    terrain_dune.texture = texture("pictures/texture_sable.png");
+    int const terrain_mesh = startup.add("terrain_mesh", task_worker, [&]() { terrain = create_terrain(); });
+    // heights of every region, read by the placement of the vegetation and of the grass
+    int const terrain_heights = startup.add("terrain_heights", task_worker, [&]() { compute_terrain(terrain, parameters); }, { terrain_mesh });
+    // the drawables are created from the computed mesh: upload only, no height computed on this thread
+    startup.add("terrain_upload", task_main, [&]() {
+        terrain_herbe = mesh_drawable(terrain);
+        terrain_berge_bas = mesh_drawable(terrain);
+        terrain_berge_milieu = mesh_drawable(terrain);
+        terrain_berge_haut = mesh_drawable(terrain);
+        terrain_dune = mesh_drawable(terrain);
+
+        // Texture Images load and association
+        terrain_dune.texture = texture("pictures/texture_sable.png");
+    }, { skybox, terrain_heights });
+
+    // Water : static mesh, sent once
+    int const water_mesh = startup.add("water_mesh", task_worker, [&]() {
+        water_shape = create_water(water_resolution, parameters);
+        water_weight = water_weights(water_shape);
+    });
+    startup.add("water_upload", task_main, [&]() {
+        terrain_water = mesh_drawable(water_shape, shader_water, texture_cubemap);
+        attach_water_weights(terrain_water, water_weight);
+    }, { skybox, water_mesh });
+
+    // Scene layout
+    int const scene_load = startup.add("scene_load", task_worker, [&]() {
+        if (!load_scene_cached(scene_filename, layout))
+            std::cerr << "Scene " << scene_filename << " could not be loaded entirely" << std::endl;
+        resolve_scene_heights(layout, parameters.terrain_height);
+        std::cout << placement_count(layout) << " placements loaded from " << scene_filename << std::endl;
+    });
 
 	// Pyramid
-	initialize_pyramid(pyramid, 0.015f);
-    pos_pyramids = generate_positions_pyramids(terrain, parameters);
+	int const pyramid_mesh = startup.add("pyramid_mesh", task_worker, [&]() { pyramid_shape = create_pyramid_shape(layout.size[prop_pyramid]); }, { scene_load });
+	startup.add("pyramid_upload", task_main, [&]() { initialize_pyramid(drawables[drawable_pyramid], pyramid_shape); }, { shaders, pyramid_mesh });
 
 	// Palm tree
-    initialize_palm_tree(palm_tree, 0.1f);
+    int const palm_mesh = startup.add("palm_tree_mesh", task_worker, [&]() { palm_shape = create_palm_tree_shape(layout.size[prop_palm_tree], 20); }, { scene_load });
+    startup.add("palm_tree_upload", task_main, [&]() { initialize_palm_tree(hierarchies[hierarchy_palm_tree], palm_shape, shader_mesh_wind); }, { shaders, palm_mesh });
 
     // column
-    initialize_column_cyl(column, 0.1f);
-    pos_columns = generate_positions_columns(terrain, parameters);
+    int const column_mesh = startup.add("column_mesh", task_worker, [&]() { column_shape = create_column_shape(layout.size[prop_column]); }, { scene_load });
+    startup.add("column_upload", task_main, [&]() { initialize_column_cyl(drawables[drawable_column], column_shape); }, { shaders, column_mesh });
 
     //obelisque
-    initialize_obelisque(obelisque, 0.1f);
-    pos_obelisques = generate_positions_obelisque(terrain, parameters);
+    int const obelisque_mesh = startup.add("obelisque_mesh", task_worker, [&]() { obelisque_shape = create_obelisque_shape(layout.size[prop_obelisque]); }, { scene_load });
+    startup.add("obelisque_upload", task_main, [&]() { initialize_obelisque(drawables[drawable_obelisque], obelisque_shape); }, { shaders, obelisque_mesh });
 
 	// Birds
-    initialize_leader_bird(bird, 0.1f, key_positions_bird, key_times_bird);
-	for (int i = 0; i < nb_follower_birds; i++) {
-		follower_birds.push_back(key_positions_bird[0] + 1.0f*vec3(static_cast <float> (rand()) / (static_cast <float> (RAND_MAX)), static_cast <float> (rand()) / (static_cast <float> (RAND_MAX)), static_cast <float> (rand()) / (static_cast <float> (RAND_MAX))));
-		speeds_birds.push_back({ 0.1f, 0.1f, 0.1f });
-	}
-	speeds_birds.push_back({ 0.1f, 0.1f, 0.1f });
+	startup.add("birds", task_main, [&]() { initialize_bird(hierarchies[hierarchy_bird], 0.1f); }, { shaders });
 
-    // Boat
-    initialize_boat(boat, 0.1f);
-    initialize_boat(boat_drift, 0.1f);
+    // Simulated systems : paths of the birds, fleet and rope
+    int const simulation = startup.add("simulation", task_worker, [&]() { initialize_simulation(sim, nb_agents_fleet); });
 
-    // Forest
-    int nbr_forest = 200;
-    pos_forest = generate_positions_forest(nbr_forest, terrain);
-    for (int i = 0; i < pos_forest.size(); i++)
-        rotation_palm_tree.push_back(static_cast <float> (rand()) / (static_cast <float> (RAND_MAX / (2 * 3.14f))));
+    // Boat
+    int const boat_mesh = startup.add("boat_mesh", task_worker, [&]() { boat_shape = create_boat_shape(0.1f); });
+    int const boat_upload = startup.add("boat_upload", task_main, [&]() {
+        initialize_boat(drawables[drawable_boat], boat_shape);
+    }, { shaders, boat_mesh });
+
+    // Fleet
+    int const fleet_mesh = startup.add("fleet_mesh", task_worker, [&]() { create_fleet_shapes(fleet_shapes, 0.1f); });
+    startup.add("fleet_upload", task_main, [&]() {
+        initialize_fleet_drawable(boats_fleet_visual, shader_mesh_instanced, drawables[drawable_boat].texture, fleet_shapes);
+    }, { boat_upload, fleet_mesh });
+
+    // Vegetation : palm trees and ferns scattered on the terrain according to the rules of each species
+    std::vector<scatter_instances> vegetation;
+    int const vegetation_scatter = startup.add("vegetation", task_worker, [&]() {
+        vegetation = scatter_vegetation(nile_species_rules(layout), terrain, default_thread_pool());
+        std::cout << "Vegetation: " << vegetation[species_palm_tree].size() << " palm trees, " << vegetation[species_fern].size() << " ferns" << std::endl;
+    }, { terrain_heights, scene_load });
+
+    // Grass : blades generated tile by tile on the workers, sent once to the GPU
+    int const grass_blades = startup.add("grass", task_worker, [&]() {
+        grass = create_grass_field(terrain, grass_parameters(), default_thread_pool());
+        std::cout << "Grass: " << grass.blades.size() << " blades" << std::endl;
+    }, { terrain_heights });
+    startup.add("grass_upload", task_main, [&]() { initialize_grass_drawable(grass_visual, grass, shader_grass); }, { shaders, grass_blades });
 
     // Fern
-    initialize_fern(fern, 0.4f);
-    pos_ferns = generate_positions_ferns(terrain, parameters);
+    int const fern_mesh = startup.add("fern_mesh", task_worker, [&]() {
+        fern_shape = create_fern_shape(layout.size[prop_fern]);
+        fern_wind = create_fern_wind(fern_shape);
+    }, { scene_load });
+    startup.add("fern_upload", task_main, [&]() { initialize_fern(drawables[drawable_fern], fern_shape, fern_wind, shader_mesh_wind); }, { shaders, fern_mesh });
 
     // rope
-    pos_poteau = { 5.5f,-7.5f,0.1f };
-    initialize_corde(boat.transform.translate + get_translation_to_bow(0.1f), pos_poteau, particules, vitesses, L0_array, raideurs);
-    sphere = mesh_drawable( mesh_primitive_sphere(0.01f));
-
-    // Set timer bounds
-	size_t const N = key_times_bird.size();
-	timer.t_min = key_times_bird[1];    // Start the timer at the first time of the keyframe
-	timer.t_max = key_times_bird[N - 2];  // Ends the timer at the last time of the keyframe
+    startup.add("rope_upload", task_main, [&]() { sphere = mesh_drawable( mesh_primitive_sphere(0.01f)); }, { shaders });
+
+    // Entities : one per placed or scattered prop, then the birds and the moored boat with its rope
+    startup.add("entities", task_main, [&]() {
+        clear(world);
+        int const prop_drawable[prop_type_count] = { drawable_pyramid, hierarchy_palm_tree, drawable_column, drawable_obelisque, drawable_fern };
+        auto add_props = [&](int type, std::vector<vec3> const& position, float const* angle, float const* scale) {
+            entity const first = create_entities(world, position.size(), component_transform | component_mesh);
+            for (size_t i = 0; i < position.size(); i++) {
+                world.position[first + i] = position[i];
+                world.angle[first + i] = angle[i];
+                world.scale[first + i] = scale ? scale[i] : 1.0f;
+                world.mesh[first + i].drawable = prop_drawable[type];
+                world.mesh[first + i].hierarchy = type == prop_palm_tree;
+            }
+        };
+        for (int type = 0; type < prop_type_count; type++)
+            add_props(type, layout.position[type], layout.rotation[type].data(), nullptr);
+        add_props(prop_palm_tree, vegetation[species_palm_tree].position, vegetation[species_palm_tree].rotation.data(), vegetation[species_palm_tree].scale.data());
+        add_props(prop_fern, vegetation[species_fern].position, vegetation[species_fern].rotation.data(), vegetation[species_fern].scale.data());
+
+        // birds, boats and rope
+        create_simulation_entities(sim, world, { hierarchy_bird, true }, { drawable_boat, false });
+        std::cout << "Entities: " << world.size() << " (" << count_entities(world, component_mesh) << " drawn)" << std::endl;
+    }, { scene_load, vegetation_scatter, simulation });
+
+    if (!startup.run(default_thread_pool()))
+        std::cerr << "Some initialization tasks failed" << std::endl;
+    startup.report(std::cout);
+    mesh_builder_statistics const merged = mesh_builder_report();
+    std::cout << "Mesh builders: " << merged.parts << " parts merged (" << merged.vertices << " vertices) with " << merged.allocations << " buffer allocations" << std::endl;
+
+    // Set timer bounds : first and last times of the keyframes of the leader bird
+	timer.t_min = sim.t_min;
+	timer.t_max = sim.t_max;
 	timer.t = timer.t_min;
 }
 
 
-void display_frame()
+// render system : the entities are created type after type, so the drawables change rarely along the pass
+// the transforms come from the snapshot, the other components do not change after the initialization
+void draw_entities(entity_store const& store, render_snapshot const& frame, scene_environment const& current_scene)
 {
+    for_each_entity(store, component_transform | component_mesh, [&](entity e) {
+        mesh_ref const& ref = store.mesh[e];
+        if (ref.hierarchy) {
+            hierarchy_mesh_drawable& drawable = hierarchies[ref.drawable];
+            auto& transform = drawable[hierarchy_root[ref.drawable]].transform;
+            transform.translate = frame.position[e];
+            transform.rotate = rotation({ 0,0,1 }, frame.angle[e]);
+            transform.scale = store.scale[e];
+            drawable.update_local_to_global_coordinates();
+            vcl::draw(drawable, current_scene);
+        }
+        else {
+            mesh_drawable& drawable = drawables[ref.drawable];
+            drawable.transform.translate = frame.position[e];
+            drawable.transform.rotate = rotation({ 0,0,1 }, frame.angle[e]);
+            drawable.transform.scale = store.scale[e];
+            vcl::draw(drawable, current_scene);
+        }
+    });
+}
+
+// simulation thread : one step per frame, no OpenGL call
+void simulate_frame(render_snapshot& frame)
+{
+    frame_arena().reset();
+    allocation_statistics const step_start_allocations = thread_allocations();
+
+    {
+        std::lock_guard<std::mutex> lock(controls_mutex);
+        timer.scale = controls.time_scale;
+        if (controls.seek_time >= 0.0f) {
+            timer.t = controls.seek_time;
+            controls.seek_time = -1.0f;
+        }
+    }
+
 	// Update the current time
-	float t_prev = t;
     timer.update();
-    t = timer.t;
+    float const t = timer.t;
     int nbr_it = 50;
     float dt = timer.scale*1/nbr_it;
 
-    perlin_noise_parameters parameters = get_noise_params();
+    // birds, boats, fleet and rope
+    sim.substeps = nbr_it;
+    step_simulation(sim, world, terrain, t, dt);
+
+    // copy of the render state: the buffers of the snapshot keep their allocation from one frame to the next
+    frame.t = t;
+    frame.dt = dt;
+    frame.t_min = timer.t_min;
+    frame.t_max = timer.t_max;
+    frame.position = world.position;
+    frame.angle = world.angle;
+    frame.rope = sim.particules;
+    frame.boats.position = sim.boats.position;
+    frame.boats.heading = sim.boats.heading;
+    std::copy(std::begin(sim.boats.kind_begin), std::end(sim.boats.kind_begin), std::begin(frame.boats.kind_begin));
+    frame.fleet_agents_per_ms = sim.boats.position.size() / std::max(sim.fleet_ms, 1e-6f);
+    frame.simulation_allocations = thread_allocations() - step_start_allocations;
+}
 
-    // update the water
-    update_terrain_water(terrain, terrain_water, parameters, t, timer.t_max);
+// render thread : draws the snapshot of the frame
+void display_frame(render_snapshot const& frame)
+{
+    // the water and the foliage move in the vertex shader: only the time and a few parameters are sent
+    water_set_uniforms(shader_water, get_noise_params(), frame.t, frame.t_max);
+    vec2 const wind = wind_strength * vec2(std::cos(wind_angle), std::sin(wind_angle));
+    wind_set_uniforms(shader_mesh_wind, frame.t, wind);
+    wind_set_uniforms(shader_grass, frame.t, wind);
 
     glDepthMask(GL_FALSE);
     draw_with_cubemap(cube_map, scene);
@@ -265,75 +531,38 @@ void display_frame()
     // draw water and only one mesh_drawable is enough
     vcl::draw(terrain_dune, scene);
     draw_with_cubemap(terrain_water, scene);
-    vcl::draw(palm_tree, scene);
 
+    // grass : thinned out with the distance, at most grass_budget blades
+    grass.parameters.budget = size_t(grass_budget);
+    draw_grass(grass_visual, grass, scene);
 
-    // pyramids
-    for(int i=0; i<pos_pyramids.size();i++){
-        pyramid.transform.translate = pos_pyramids[i];
-        vcl::draw(pyramid, scene);
-    }
+    // props, birds and boats : one pass over the entities having a transform and a mesh
+    animate_bird_wings(hierarchies[hierarchy_bird], frame.t);
+    draw_entities(world, frame, scene);
 
-    // columns
-    for(int i=0; i<pos_columns.size();i++){
-        column.transform.translate = pos_columns[i];
-        vcl::draw(column, scene);
-    }
-
-    // obelisques
-    for(int i=0; i<pos_obelisques.size();i++){
-        obelisque.transform.translate = pos_obelisques[i];
-        vcl::draw(obelisque, scene);
-    }
+    // fleet of boats : one draw call per kind of boat
+    draw_fleet(boats_fleet_visual, frame.boats, dynamic_vertices, scene);
 
-    // palm forest
-    for(int i=0; i<pos_forest.size();i++){
-        palm_tree["trunk"].transform.translate = pos_forest[i];
-        palm_tree["trunk"].transform.rotate = rotation({ 0,0,1 }, rotation_palm_tree[i]);
-        palm_tree.update_local_to_global_coordinates();
-        vcl::draw(palm_tree, scene);
-    }
-
-    // ferns : add "/*" and "*/" to remove ferns and gain FPS
-    for(int i=0; i<pos_ferns.size();i++){
-        fern.transform.translate = pos_ferns[i];
-        vcl::draw(fern, scene);
-    }
-
-    // drifting boat
-    update_boat_drift(boat_drift, t);
-    vcl::draw(boat_drift, scene);
-
-    // birds
-	update_leader_bird(bird, t, dt, key_positions_bird, key_times_bird, speeds_birds);
-    //vcl::draw(bird, scene);   // remove comment to draw the leading bird
-	for (int i = 0; i < nbr_it; i++) {
-		update_follower_birds(bird, follower_birds, speeds_birds, t, dt, 0.0001f, 0.0001f, 0.005f);
-	}
-	for (auto pos : follower_birds) {
-		bird["body"].transform.translate = pos;
-		bird.update_local_to_global_coordinates();
-		vcl::draw(bird, scene);
-		//std::cout << pos[0] << " " << pos[1] << " " << pos[2] << std::endl;
-    }
-
-    // attached boat
-    update_pos_boat(boat, t, timer.t_max);
-    for(int i=0; i<nbr_it; i++){
-        update_pos_rope(boat.transform.translate + get_translation_to_bow(0.1f), particules,vitesses,L0_array,raideurs,terrain,t,dt, timer.t_max);
-    }
-    vcl::draw(boat, scene);
+    // rope of the moored boat
     sphere.shading.color = {1,1,1};
-    for(int i=0; i<10; i++){
-        sphere.transform.translate = particules[i];
+    for(size_t i=0; i<frame.rope.size(); i++){
+        sphere.transform.translate = frame.rope[i];
         //draw(sphere, scene);
     }
-    for(int i=1; i<10; i++){
-        segments.update({particules[i-1],particules[i]});
-        draw(segments, scene);
+    add_polyline(lines, ptr(frame.rope), frame.rope.size(), { 1,1,1 });
+
+    // debug lines : paths of the leader bird and of the boats, axes of the world frame
+    if (user.gui.display_trajectory) {
+        add_polyline(lines, ptr(sim.key_positions_bird), sim.key_positions_bird.size(), { 1,1,0 });
+        for (river_path const& path : sim.river_paths)
+            add_polyline(lines, ptr(path.key_positions), path.key_positions.size(), { 0,0.4f,1 });
     }
+    if (user.gui.display_frame)
+        add_frame(lines, { 0,0,0 }, 1.0f);
+    draw_line_batch(lines, dynamic_vertices, scene);
 
     // Handle camera fly-through
+    float const dt = frame.dt;
     scene.camera_head.position_camera += user.speed*0.1f*dt*scene.camera_head.front();
     if(user.keyboard_state.up)
         scene.camera_head.manipulator_rotate_roll_pitch_yaw(0,1.0f*dt,0);
@@ -351,14 +580,36 @@ void display_frame()
 
 
 
-void display_interface()
+void display_interface(render_snapshot const& frame)
 {
-	ImGui::SliderFloat("Time", &timer.t, timer.t_min, timer.t_max);
-	ImGui::SliderFloat("Time scale", &timer.scale, 0.0f, 2.0f);
+	// the timer belongs to the simulation thread: the sliders send requests to it
+	float time = frame.t;
+	if (ImGui::SliderFloat("Time", &time, frame.t_min, frame.t_max)) {
+		std::lock_guard<std::mutex> lock(controls_mutex);
+		controls.seek_time = time;
+	}
+	{
+		std::lock_guard<std::mutex> lock(controls_mutex);
+		ImGui::SliderFloat("Time scale", &controls.time_scale, 0.0f, 2.0f);
+	}
 	ImGui::Checkbox("Frame", &user.gui.display_frame);
+	ImGui::Checkbox("Trajectories", &user.gui.display_trajectory);
 	ImGui::Checkbox("Surface", &user.gui.display_surface);
     ImGui::Checkbox("Wireframe", &user.gui.display_wireframe);
     ImGui::SliderFloat("Speed", &user.speed, -100.0f, 100.0f);
+    ImGui::SliderFloat("Wind", &wind_strength, 0.0f, 0.2f);
+    ImGui::SliderFloat("Wind direction", &wind_angle, 0.0f, 2 * 3.14f);
+    ImGui::SliderInt("Grass budget", &grass_budget, 0, 2000000);
+    ImGui::Text("Grass: %d blades drawn in %d tiles (density x%.2f)", int(grass_visual.drawn_blades), int(grass_visual.draws.size()), grass_visual.budget_scale);
+    ImGui::Text("Fleet: %d agents, %.0f agents/ms", int(frame.boats.position.size()), frame.fleet_agents_per_ms);
+    ImGui::Text("Simulation: %.2f ms per step, render thread waited %.2f ms", float(pipeline.step_ms), pipeline.wait_ms);
+    ImGui::Text("Lines: %d segments in one draw call", int(lines.drawn_segments));
+    ImGui::Text("Streaming: %.0f KB per frame, stalled %.2f ms waiting for the GPU", dynamic_vertices.written_bytes / 1024.0f, dynamic_vertices.stall_ms);
+    ImGui::Text("Heap allocations per frame: render %d, simulation %d", int(render_frame_allocations.allocations), int(frame.simulation_allocations.allocations));
+    static texture_registry_statistics textures;
+    if (user.fps_record.event)  // the GPU memory is measured about once per second
+        textures = texture_registry_report();
+    ImGui::Text("Textures: %d (%d users), %.1f MB on GPU", int(textures.textures), int(textures.references), textures.bytes / (1024.0f * 1024.0f));
 }
 
 
@@ -0,0 +1,68 @@
+#include "helpers/poisson_disk.hpp"
+#include "helpers/random.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+// Poisson-disk sampling with a density reaching 0 and density_min = 0:
+// the search range must stay finite, and every pair of samples must respect the larger of their local distances
+
+using namespace vcl;
+
+
+namespace {
+
+int failures = 0;
+
+void check(bool condition, char const* message)
+{
+    if (!condition) {
+        std::fprintf(stderr, "FAILED: %s\n", message);
+        failures++;
+    }
+}
+
+}
+
+
+int main()
+{
+    rng_set_global_seed(1);
+
+    poisson_disk_parameters parameters;
+    parameters.domain_min = { 0.0f, 0.0f };
+    parameters.domain_max = { 20.0f, 20.0f };
+    parameters.radius = 0.5f;
+    parameters.density_min = 0.0f;
+    // 1 on the left, 0 on the whole right half
+    parameters.density = [](vec2 const& p) { return std::max(1.0f - p.x / 10.0f, 0.0f); };
+    parameters.name = "poisson_disk_test";
+
+    std::vector<vec2> const samples = poisson_disk_sample(parameters, default_thread_pool());
+    check(!samples.empty(), "samples are generated");
+
+    auto local_radius = [&](vec2 const& p) {
+        float const d = std::min(std::max(parameters.density(p), poisson_density_floor), 1.0f);
+        return parameters.radius / std::sqrt(d);
+    };
+
+    size_t right_half = 0;
+    bool inside = true, spaced = true;
+    for (size_t i = 0; i < samples.size(); i++) {
+        vec2 const& p = samples[i];
+        inside = inside && p.x >= 0.0f && p.y >= 0.0f && p.x <= 20.0f && p.y <= 20.0f && std::isfinite(p.x) && std::isfinite(p.y);
+        right_half += p.x > 10.0f;
+        for (size_t j = i + 1; j < samples.size(); j++) {
+            vec2 const& q = samples[j];
+            float const dmin = std::max(local_radius(p), local_radius(q));
+            spaced = spaced && (p.x - q.x) * (p.x - q.x) + (p.y - q.y) * (p.y - q.y) >= dmin * dmin * (1.0f - 1e-4f);
+        }
+    }
+    check(inside, "samples are finite and inside the domain");
+    check(spaced, "samples respect their local distance");
+    // at density 0 the distance is radius / sqrt(poisson_density_floor): a few samples, not none and not a dense set
+    check(right_half > 0 && right_half < 20, "sparse samples where the density is 0");
+
+    std::printf("%zu samples, %zu where the density is 0\n", samples.size(), right_half);
+    return failures == 0 ? 0 : 1;
+}